@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Collider.h"
+
+#include <Vec3.h>
+#include <Vec4.h>
+#include <Mat4.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using PolandBall::Game::Collider;
+
+namespace {
+
+const int COLLIDERS = 1024;
+const int ROUNDS = 20;
+
+// Former Collider::getCollideBox(), kept as the baseline
+Collider::Box getMatrixBox(const std::unique_ptr<Collider>& collider) {
+    static const std::array<Math::Vec3, 4> collideBox = {{
+        Math::Vec3( 0.5f,  0.5f,  0.0f),
+        Math::Vec3(-0.5f,  0.5f,  0.0f),
+        Math::Vec3(-0.5f, -0.5f,  0.0f),
+        Math::Vec3( 0.5f, -0.5f,  0.0f)
+    }};
+
+    Math::Vec3 position = collider->getPosition();
+    Math::Mat4 translation;
+    translation.set(0, 3, position.get(Math::Vec3::X));
+    translation.set(1, 3, position.get(Math::Vec3::Y));
+    translation.set(2, 3, position.get(Math::Vec3::Z));
+
+    Math::Mat4 scaling;
+    scaling.set(0, 0, collider->getXFactor());
+    scaling.set(1, 1, collider->getYFactor());
+    scaling.set(2, 2, collider->getZFactor());
+
+    std::array<Math::Vec3, 4> realBox;
+    Math::Mat4 transformation = translation * scaling;
+
+    for (int i = 0; i < 4; i++) {
+        realBox[i] = (transformation * Math::Vec4(collideBox[i], 1.0f)).extractVec3();
+    }
+
+    return { realBox[1].get(Math::Vec3::X), realBox[0].get(Math::Vec3::X),
+             realBox[3].get(Math::Vec3::Y), realBox[0].get(Math::Vec3::Y) };
+}
+
+template<typename Test>
+double measure(const std::vector<std::unique_ptr<Collider>>& colliders, std::vector<int>& sides, Test test) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < COLLIDERS; i++) {
+            for (int j = 0; j < COLLIDERS; j++) {
+                sides[i * COLLIDERS + j] += test(colliders[i], colliders[j]);
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double pairs = static_cast<double>(ROUNDS) * COLLIDERS * COLLIDERS;
+    return std::chrono::duration<double, std::nano>(end - begin).count() / pairs;
+}
+
+// One box against all the others packed, like Scene does with body neighbours
+double measureBatch(const std::vector<std::unique_ptr<Collider>>& colliders, std::vector<int>& sides) {
+    std::vector<float> left, right, bottom, top;
+    for (auto& collider: colliders) {
+        left.push_back(collider->getBox().left);
+        right.push_back(collider->getBox().right);
+        bottom.push_back(collider->getBox().bottom);
+        top.push_back(collider->getBox().top);
+    }
+
+    std::vector<Collider::CollideSide> batch(COLLIDERS);
+    auto begin = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < COLLIDERS; i++) {
+            Collider::classify(colliders[i]->getBox(), left.data(), right.data(), bottom.data(), top.data(),
+                    COLLIDERS, batch.data());
+
+            for (int j = 0; j < COLLIDERS; j++) {
+                sides[i * COLLIDERS + j] += (i != j) ? batch[j] : Collider::SIDE_NONE;
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double pairs = static_cast<double>(ROUNDS) * COLLIDERS * COLLIDERS;
+    return std::chrono::duration<double, std::nano>(end - begin).count() / pairs;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> position(-40, 40);
+    std::uniform_int_distribution<int> factor(1, 12);
+
+    // Quarter unit grid, so plenty of boxes share edges exactly
+    std::vector<std::unique_ptr<Collider>> colliders;
+    for (int i = 0; i < COLLIDERS; i++) {
+        std::unique_ptr<Collider> collider(new Collider());
+        collider->setPosition(position(generator) * 0.25f, position(generator) * 0.25f, 0.0f);
+        collider->scaleX(factor(generator) * 0.25f);
+        collider->scaleY(factor(generator) * 0.25f);
+        colliders.push_back(std::move(collider));
+    }
+
+    std::vector<int> matrixSides(COLLIDERS * COLLIDERS, 0);
+    std::vector<int> cachedSides(COLLIDERS * COLLIDERS, 0);
+
+    double matrixTime = measure(colliders, matrixSides,
+            [](const std::unique_ptr<Collider>& collider, const std::unique_ptr<Collider>& another) -> int {
+        if (collider == another) {
+            return Collider::SIDE_NONE;
+        }
+
+        return Collider::classify(getMatrixBox(collider), getMatrixBox(another));
+    });
+
+    double cachedTime = measure(colliders, cachedSides,
+            [](const std::unique_ptr<Collider>& collider, const std::unique_ptr<Collider>& another) -> int {
+        return collider->collides(another);
+    });
+
+    std::vector<int> batchSides(COLLIDERS * COLLIDERS, 0);
+    double batchTime = measureBatch(colliders, batchSides);
+
+    int mismatches = 0;
+    for (int i = 0; i < COLLIDERS * COLLIDERS; i++) {
+        mismatches += (matrixSides[i] != cachedSides[i] || matrixSides[i] != batchSides[i]) ? 1 : 0;
+    }
+
+    printf("collider pairs:   %d x %d, %d rounds\n", COLLIDERS, COLLIDERS, ROUNDS);
+    printf("matrix transform: %.2f ns/pair\n", matrixTime);
+    printf("cached box:       %.2f ns/pair (%.1fx)\n", cachedTime, matrixTime / cachedTime);
+    printf("batch of boxes:   %.2f ns/pair (%.1fx)\n", batchTime, matrixTime / batchTime);
+    printf("mismatches:       %d\n", mismatches);
+
+    return (mismatches == 0) ? 0 : 1;
+}
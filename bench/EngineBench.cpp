@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Collider.h"
+#include "Context.h"
+#include "EntityFactory.h"
+#include "Label.h"
+#include "Logger.h"
+#include "RenderEffect.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "Sprite.h"
+#include "SpriteEntity.h"
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+#include <Mat4.h>
+#include <Vec3.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace PolandBall;
+
+namespace {
+
+// One line of the report, time per single operation
+typedef struct {
+    std::string name;
+    long long iterations;
+    double nanoseconds;
+    bool skipped;  // Needs a GL context we could not get
+    int drawCalls;  // Per operation, -1 if it does not draw
+} Result;
+
+std::vector<Result> results;
+volatile int sink;  // Keeps results of the measured calls alive
+
+// Runs test() once to warm caches, then until minTime passed, in batches of iterations
+template<typename Test>
+void measure(const std::string& name, long long iterations, Test test) {
+    const double minTime = 0.2e9;
+
+    test(iterations);
+
+    long long total = 0;
+    double elapsed = 0.0;
+    while (elapsed < minTime) {
+        auto begin = std::chrono::steady_clock::now();
+        test(iterations);
+        auto end = std::chrono::steady_clock::now();
+
+        elapsed += std::chrono::duration<double, std::nano>(end - begin).count();
+        total += iterations;
+    }
+
+    results.push_back({name, total, elapsed / total, false, -1});
+}
+
+void skip(const std::string& name) {
+    results.push_back({name, 0, 0.0, true, -1});
+}
+
+bool initContext(SDL_Window*& window, SDL_GLContext& context) {
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE) || TTF_Init() || !IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG)) {
+        return false;
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+
+    window = SDL_CreateWindow("polandball_bench", 0, 0, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (window == nullptr) {
+        return false;
+    }
+
+    context = SDL_GL_CreateContext(window);
+    if (context == nullptr) {
+        return false;
+    }
+
+    glewExperimental = GL_TRUE;
+    return glewInit() == GLEW_OK && Opengl::Sprite::createQuad();
+}
+
+void benchCollider() {
+    const int colliders = 256;
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> position(-40, 40);
+    std::uniform_int_distribution<int> factor(1, 12);
+
+    std::vector<std::unique_ptr<Game::Collider>> boxes;
+    for (int i = 0; i < colliders; i++) {
+        std::unique_ptr<Game::Collider> collider(new Game::Collider());
+        collider->setPosition(position(generator) * 0.25f, position(generator) * 0.25f, 0.0f);
+        collider->scaleX(factor(generator) * 0.25f);
+        collider->scaleY(factor(generator) * 0.25f);
+        boxes.push_back(std::move(collider));
+    }
+
+    measure("Collider::collides", colliders * colliders, [&boxes](long long) {
+        int sides = 0;
+        for (auto& collider: boxes) {
+            for (auto& another: boxes) {
+                sides += collider->collides(another);
+            }
+        }
+
+        sink = sides;
+    });
+}
+
+// Bodies dropped in a grid over a floor, most of them end up stacked or asleep like in a level
+void benchSceneUpdate(int entities) {
+    Game::Scene scene;
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+
+    int columns = 1;
+    while (columns * columns < entities) {
+        columns++;
+    }
+
+    std::shared_ptr<Game::SpriteEntity> floor(new Game::SpriteEntity());
+    floor->setPosition(0.0f, -1.0f, 0.0f);
+    floor->scaleX(columns * 1.5f + 2.0f);
+    scene.addEntity(floor);
+
+    for (int i = 0; i < entities; i++) {
+        std::shared_ptr<Game::SpriteEntity> body(new Game::SpriteEntity());
+        body->setPosition((i % columns) * 1.5f - columns * 0.75f + jitter(generator),
+                (i / columns) * 1.5f + jitter(generator), 0.0f);
+        body->scale(0.5f + jitter(generator));
+        body->setPassive(false);
+        scene.addEntity(body);
+    }
+
+    std::string name("Scene::update/" + std::to_string(entities));
+    measure(name, 10, [&scene](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            scene.update(0.01f, 0.001f);
+        }
+    });
+}
+
+// Blocks of a few textures drawn one by one, batched per texture or batched per atlas page
+void benchSceneRender(int entities, bool batched, bool atlas, bool context) {
+    std::string mode(atlas ? "atlas/" : (batched ? "batched/" : "single/"));
+    std::string name("Scene::render/" + mode + std::to_string(entities));
+    if (!context) {
+        skip(name);
+        return;
+    }
+
+    const std::string assets[] = {
+        "assets/blocks/kazakhstan.asset",
+        "assets/items/pack_health.asset",
+        "assets/items/pack_armor.asset",
+        "assets/weapons/ak74.asset"
+    };
+
+    auto& factory = Game::EntityFactory::getInstance();
+    if (atlas) {
+        factory.getResourceCache()->purge();
+        factory.getResourceCache()->buildAtlas(std::vector<std::string>(assets, assets + 4));
+    }
+
+    Game::Scene scene;
+    if (batched) {
+        scene.setBatchEffect(factory.getResourceCache()->loadEffect("shaders/sprite.shader"),
+                factory.getResourceCache()->loadEffect("shaders/batch.shader"));
+    }
+
+    for (int i = 0; i < entities; i++) {
+        auto block = factory.createBlock(assets[i % 4]);
+        block->setPosition((i % 100) * 0.1f - 5.0f, (i / 100) * 0.1f - 2.5f, 0.0f);
+        block->scale(0.1f);
+        scene.addEntity(block);
+    }
+
+    measure(name, 10, [&scene](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            scene.render();
+        }
+
+        glFinish();
+    });
+
+    results.back().drawCalls = scene.getDrawCalls();
+}
+
+void benchEntityFactory() {
+    auto& factory = Game::EntityFactory::getInstance();
+
+    // Assets are cached after the first call, these time the building alone
+    measure("EntityFactory::createBlock", 100, [&factory](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            sink = factory.createBlock("assets/blocks/kazakhstan.asset") != nullptr;
+        }
+    });
+
+    measure("EntityFactory::createPlayer", 100, [&factory](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            sink = factory.createPlayer("assets/players/turkey.asset") != nullptr;
+        }
+    });
+
+    measure("EntityFactory::createWeapon", 100, [&factory](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            sink = factory.createWeapon("assets/weapons/ak74.asset") != nullptr;
+        }
+    });
+
+    measure("EntityFactory::createPack", 100, [&factory](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            sink = factory.createPack("assets/items/pack_health.asset") != nullptr;
+        }
+    });
+
+    measure("EntityFactory::createWidget", 100, [&factory](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            sink = factory.createWidget("assets/ui/cursor_aim.asset") != nullptr;
+        }
+    });
+}
+
+void benchResourceCache(bool context) {
+    auto& cache = Game::EntityFactory::getInstance().getResourceCache();
+
+    measure("ResourceCache::loadAsset/hit", 1000, [&cache](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            sink = cache->loadAsset("assets/players/turkey.asset") != nullptr;
+        }
+    });
+
+    measure("ResourceCache::loadAsset/miss", 10, [&cache](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            cache->purge();
+            sink = cache->loadAsset("assets/players/turkey.asset") != nullptr;
+        }
+    });
+
+    if (!context) {
+        skip("ResourceCache::loadTexture/hit");
+        skip("ResourceCache::loadTexture/miss");
+        return;
+    }
+
+    measure("ResourceCache::loadTexture/hit", 1000, [&cache](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            sink = cache->loadTexture("textures/players/turkey.png") != nullptr;
+        }
+    });
+
+    measure("ResourceCache::loadTexture/miss", 10, [&cache](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            cache->purge();
+            sink = cache->loadTexture("textures/players/turkey.png") != nullptr;
+        }
+    });
+}
+
+void benchLabel(bool context) {
+    if (!context) {
+        skip("Label::renderText");
+        return;
+    }
+
+    auto label = Game::EntityFactory::getInstance().createLabel("dejavu-sans", 14);
+    const std::string texts[] = {"100", "99"};
+
+    // setText() renders only when the text changes, alternate to render every call
+    measure("Label::renderText", 100, [&label, &texts](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            label->setText(texts[i % 2]);
+        }
+    });
+}
+
+void benchRenderEffect(bool context) {
+    if (!context) {
+        skip("RenderEffect::setUniform");
+        return;
+    }
+
+    auto effect = Game::EntityFactory::getInstance().getResourceCache()->loadEffect("shaders/sprite.shader");
+    Math::Mat4 matrix;
+
+    measure("RenderEffect::setUniform", 10000, [&effect, &matrix](long long iterations) {
+        for (long long i = 0; i < iterations; i++) {
+            effect->setUniform("mvp", matrix);
+        }
+    });
+}
+
+void report(FILE* stream, bool context) {
+    fprintf(stream, "{\n");
+    fprintf(stream, "  \"compiler\": \"%s\",\n", __VERSION__);
+#ifdef NDEBUG
+    fprintf(stream, "  \"assertions\": false,\n");
+#else
+    fprintf(stream, "  \"assertions\": true,\n");
+#endif
+    fprintf(stream, "  \"context\": %s,\n", context ? "true" : "false");
+    fprintf(stream, "  \"benchmarks\": [\n");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        fprintf(stream, "    {\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, \"skipped\": %s",
+                result.name.c_str(), result.iterations, result.nanoseconds, result.skipped ? "true" : "false");
+        if (result.drawCalls > -1) {
+            fprintf(stream, ", \"draw_calls\": %d", result.drawCalls);
+        }
+
+        fprintf(stream, "}%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+
+    fprintf(stream, "  ]\n");
+    fprintf(stream, "}\n");
+}
+
+}  // namespace
+
+// polandball_bench [report.json], the report goes to stdout without a file name
+int main(int argc, char** argv) {
+    Utils::Logger::getInstance().setThreshold(Utils::Logger::LOG_ERROR);
+
+    SDL_Window* window = nullptr;
+    SDL_GLContext context = nullptr;
+    bool hasContext = initContext(window, context);
+    if (!hasContext) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "No GL context (%s), skipping GL benchmarks",
+                SDL_GetError());
+        Opengl::Context::setAvailable(false);
+    }
+
+    benchCollider();
+    benchSceneUpdate(100);
+    benchSceneUpdate(1000);
+    benchSceneUpdate(5000);
+    benchSceneRender(1000, false, false, hasContext);
+    benchSceneRender(1000, true, false, hasContext);
+    benchSceneRender(1000, true, true, hasContext);
+    benchEntityFactory();
+    benchResourceCache(hasContext);
+    benchLabel(hasContext);
+    benchRenderEffect(hasContext);
+
+    FILE* stream = (argc > 1) ? fopen(argv[1], "w") : stdout;
+    if (stream == nullptr) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Failed to open `%s' for writing", argv[1]);
+        return 1;
+    }
+
+    report(stream, hasContext);
+    if (stream != stdout) {
+        fclose(stream);
+    }
+
+    Game::EntityFactory::getInstance().getResourceCache()->purge();
+    Opengl::Sprite::destroyQuad();
+    if (context != nullptr) {
+        SDL_GL_DeleteContext(context);
+    }
+
+    if (window != nullptr) {
+        SDL_DestroyWindow(window);
+    }
+
+    IMG_Quit();
+    TTF_Quit();
+    SDL_Quit();
+    return 0;
+}
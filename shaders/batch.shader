@@ -0,0 +1,34 @@
+#version 330
+
+#ifdef TYPE_VERTEX
+    uniform mat4 mvp;
+
+    layout(location = 0) in vec3 vertexPosition;
+    layout(location = 1) in vec2 vertexUv;
+    layout(location = 2) in mat4 instanceLw;         // Rows of lw, one instance per sprite
+    layout(location = 6) in vec4 instanceTransform;  // UV scale in xy, offset in zw
+    layout(location = 7) in vec4 instanceRegion;
+    smooth out vec2 fragmentUv;
+    flat out vec4 fragmentRegion;
+
+    void main () {
+        fragmentUv = vertexUv * instanceTransform.xy + instanceTransform.zw;
+        fragmentRegion = instanceRegion;
+        gl_Position = mvp * transpose(instanceLw) * vec4(vertexPosition, 1.0f);
+    }
+#endif
+
+#ifdef TYPE_FRAGMENT
+    uniform sampler2D textureSampler;
+
+    smooth in vec2 fragmentUv;
+    flat in vec4 fragmentRegion;
+    out vec4 fragmentColor;
+
+    void main() {
+        // Same wrapping as sprite.shader
+        vec2 regionUv = fragmentRegion.xy + fract(fragmentUv) * fragmentRegion.zw;
+        fragmentColor = textureGrad(textureSampler, regionUv,
+                dFdx(fragmentUv) * fragmentRegion.zw, dFdy(fragmentUv) * fragmentRegion.zw);
+    }
+#endif
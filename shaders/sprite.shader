@@ -17,11 +17,15 @@
 
 #ifdef TYPE_FRAGMENT
     uniform sampler2D textureSampler;
+    uniform vec4 region;  // Part of the texture, the whole one outside of an atlas
 
     smooth in vec2 fragmentUv;
     out vec4 fragmentColor;
 
     void main() {
-        fragmentColor = texture(textureSampler, fragmentUv);
+        // Wraps inside the region, gradients of the unwrapped UVs keep mipmaps stable across the seam
+        vec2 regionUv = region.xy + fract(fragmentUv) * region.zw;
+        fragmentColor = textureGrad(textureSampler, regionUv,
+                dFdx(fragmentUv) * region.zw, dFdy(fragmentUv) * region.zw);
     }
 #endif
@@ -24,15 +24,19 @@
 #include "Logger.h"
 #include "Sprite.h"
 #include "EntityFactory.h"
+#include "Context.h"
+#include "Profiler.h"
+#include "StressTest.h"
 
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <cstdio>
 #include <cstdlib>
+#include <cmath>
 #include <Vec3.h>
-#include <Vec4.h>
-#include <Mat4.h>
 #include <sstream>
+#include <string>
 
 namespace PolandBall {
 
@@ -45,6 +49,16 @@ PolandBall::PolandBall(int argc, char** argv) {
     this->running = true;
     this->frameTime = 0.0f;
     this->frameStep = 0.001f;
+    this->tickTime = 0.0f;
+    this->accumulator = 0.0f;
+
+    this->unitPixels = 1.0f;
+    this->ticks = 0;
+    this->frames = 0;
+    this->stressSteps = 0;
+    this->stressTicks = 0;
+    this->simulatedTime = 0.0f;
+    this->pendingButtons = 0;
 }
 
 int PolandBall::exec() {
@@ -61,37 +75,65 @@ int PolandBall::exec() {
         return ERROR_SETUP;
     }
 
-    SDL_Event event;
-    while (this->running) {
-        unsigned int beginFrame = SDL_GetTicks();
-
-        while (SDL_PollEvent(&event)) {
-            switch (event.type) {
-                case SDL_QUIT:
-                    this->running = false;
-                    break;
+    if (this->headless) {
+        this->runHeadless();
+        this->shutdown();
+        return ERROR_OK;
+    }
 
-                case SDL_MOUSEMOTION:
-                    this->onMouseMotion(event.motion);
-                    break;
+    float frequency = SDL_GetPerformanceFrequency();
+    Uint64 lastFrame = SDL_GetPerformanceCounter();
 
-                case SDL_MOUSEBUTTONDOWN:
-                    this->onMouseButton(event.button);
-                    break;
+    SDL_Event event;
+    while (this->running) {
+        PROFILE_ZONE("Frame");
+
+        Uint64 beginFrame = SDL_GetPerformanceCounter();
+        this->frameTime = (beginFrame - lastFrame) / frequency;
+        lastFrame = beginFrame;
+
+        {
+            PROFILE_ZONE("PolandBall::pollEvents");
+            while (SDL_PollEvent(&event)) {
+                switch (event.type) {
+                    case SDL_QUIT:
+                        this->running = false;
+                        break;
+
+                    case SDL_KEYDOWN:
+                        if (event.key.keysym.scancode == SDL_SCANCODE_F12 && !event.key.repeat) {
+                            this->dumpProfile();
+                        }
+                        break;
+
+                    case SDL_MOUSEMOTION:
+                        this->onMouseMotion(event.motion);
+                        break;
+
+                    case SDL_MOUSEBUTTONDOWN:
+                        this->onMouseButton(event.button);
+                        break;
+                }
             }
         }
 
         this->onIdle();
 
-        this->frameTime = (SDL_GetTicks() - beginFrame) / 1000.0f;
+        float busyTime = (SDL_GetPerformanceCounter() - beginFrame) / frequency;
         float maxFrameTime = 1.0f / this->maxFps;
 
-        if (this->frameTime < maxFrameTime) {
-            SDL_Delay((maxFrameTime - this->frameTime) * 1000);
-            this->frameTime = maxFrameTime;
+        // Stress runs measure what frames cost, replays run as fast as recorded ticks can be simulated
+        if (busyTime < maxFrameTime && this->stressTest == nullptr && this->replayPath.empty()) {
+            PROFILE_ZONE("PolandBall::delay");
+            SDL_Delay((maxFrameTime - busyTime) * 1000);
         }
 
-        SDL_GL_SwapWindow(this->window);
+        {
+            PROFILE_ZONE("SDL_GL_SwapWindow");
+            SDL_GL_SwapWindow(this->window);
+        }
+
+        this->onFrameEnd((SDL_GetPerformanceCounter() - beginFrame) / frequency);
     }
 
     this->shutdown();
@@ -101,6 +143,15 @@ int PolandBall::exec() {
 bool PolandBall::initialize() {
     Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Initializing...");
 
+    if (!this->initInput()) {
+        return false;
+    }
+
+    if (this->headless) {
+        Opengl::Context::setAvailable(false);
+        return this->initScene();
+    }
+
     if (!this->initSDL() || !this->initOpenGL()) {
         return false;
     }
@@ -112,10 +163,31 @@ bool PolandBall::initialize() {
     return true;
 }
 
+void PolandBall::runHeadless() {
+    // No frame limiter, ticks follow each other as fast as they are simulated
+    float tickTime = (this->tickTime > 0.0f) ? this->tickTime : 1.0f / this->maxFps;
+    float frequency = SDL_GetPerformanceFrequency();
+    Uint64 begin = SDL_GetPerformanceCounter();
+
+    while (this->running && (this->maxTicks == 0 || this->ticks < this->maxTicks)) {
+        Uint64 beginTick = SDL_GetPerformanceCounter();
+        this->onTick(tickTime);
+        this->onFrameEnd((SDL_GetPerformanceCounter() - beginTick) / frequency);
+    }
+
+    float wallTime = (SDL_GetPerformanceCounter() - begin) / frequency;
+    Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Simulated %d ticks (%.3f s) in %.3f s",
+            this->ticks, this->simulatedTime, wallTime);
+}
+
 void PolandBall::shutdown() {
-    this->scene->getCamera().positionChanged.disconnectAll();
-    if (this->player != nullptr) {
-        this->player->positionChanged.disconnectAll();
+    if (this->inputLog.isOpen()) {
+        // Equal hashes tell a replay went exactly like the recorded session, no scene if startup failed
+        if (this->scene != nullptr) {
+            Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Final state after %d ticks: %016llx",
+                    this->ticks, this->scene->getStateHash());
+        }
+        this->inputLog.close();
     }
 
     this->player.reset();
@@ -132,7 +204,9 @@ void PolandBall::shutdown() {
     this->health.reset();
 
     Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Cleaning caches...");
+    Game::EntityFactory::getInstance().clearTraces();
     Game::EntityFactory::getInstance().getResourceCache()->purge();
+    Opengl::Sprite::destroyQuad();
 
     if (this->context) {
         SDL_GL_DeleteContext(this->context);
@@ -158,6 +232,31 @@ bool PolandBall::parseCLI() {
             Utils::ArgumentParser::ArgumentType::TYPE_INT);
     this->arguments.addArgument('w', "width", "viewport width",
             Utils::ArgumentParser::ArgumentType::TYPE_INT);
+    this->arguments.addArgument('b', "broadphase", "collision broad phase (grid, naive)",
+            Utils::ArgumentParser::ArgumentType::TYPE_STRING);
+    this->arguments.addArgument('s', "solver", "physics solver (substep, continuous)",
+            Utils::ArgumentParser::ArgumentType::TYPE_STRING);
+    this->arguments.addArgument('j', "threads", "physics worker threads",
+            Utils::ArgumentParser::ArgumentType::TYPE_INT);
+    this->arguments.addArgument('t', "tickrate", "fixed simulation ticks per second (0 follows fps)",
+            Utils::ArgumentParser::ArgumentType::TYPE_FLOAT);
+    this->arguments.addArgument('H', "headless", "simulate without window nor rendering",
+            Utils::ArgumentParser::ArgumentType::TYPE_BOOL);
+    this->arguments.addArgument('n', "ticks", "ticks to simulate in headless mode (0 runs until killed), "
+            "ticks per step with --stress",
+            Utils::ArgumentParser::ArgumentType::TYPE_INT);
+    this->arguments.addArgument('r', "record", "record input to a file",
+            Utils::ArgumentParser::ArgumentType::TYPE_STRING);
+    this->arguments.addArgument('p', "replay", "replay input recorded to a file",
+            Utils::ArgumentParser::ArgumentType::TYPE_STRING);
+    this->arguments.addArgument('S', "seed", "gameplay random seed",
+            Utils::ArgumentParser::ArgumentType::TYPE_INT);
+    this->arguments.addArgument('x', "stress", "fill the level with blocks,weapons,packs,bots per step",
+            Utils::ArgumentParser::ArgumentType::TYPE_STRING);
+    this->arguments.addArgument('X', "stress-steps", "stress steps to sweep through, reporting frame times",
+            Utils::ArgumentParser::ArgumentType::TYPE_INT);
+    this->arguments.addArgument('P', "profile-frames", "dump a profiler trace after that many frames (F12 dumps too)",
+            Utils::ArgumentParser::ArgumentType::TYPE_INT);
 
     this->arguments.setDescription(POLANDBALL_DESCRIPTION);
     this->arguments.setVersion(POLANDBALL_VERSION);
@@ -167,9 +266,152 @@ bool PolandBall::parseCLI() {
     }
 
     this->vsync = this->arguments.isSet("vsync");
+    this->headless = this->arguments.isSet("headless");
+    this->maxTicks = this->arguments.isSet("ticks") ? atoi(this->arguments.getOption("ticks").c_str()) : 0;
     this->maxFps = this->arguments.isSet("fps") ? atof(this->arguments.getOption("fps").c_str()) : 100.0f;
     this->height = this->arguments.isSet("height") ? atoi(this->arguments.getOption("height").c_str()) : 600;
     this->width = this->arguments.isSet("width") ? atoi(this->arguments.getOption("width").c_str()) : 800;
+    this->threads = this->arguments.isSet("threads") ? atoi(this->arguments.getOption("threads").c_str()) : 1;
+    this->seed = this->arguments.isSet("seed") ? strtoul(this->arguments.getOption("seed").c_str(), nullptr, 10) :
+            static_cast<unsigned int>(DEFAULT_SEED);
+    this->profileFrames = this->arguments.isSet("profile-frames") ?
+            atoi(this->arguments.getOption("profile-frames").c_str()) : 0;
+    this->recordPath = this->arguments.isSet("record") ? this->arguments.getOption("record") : "";
+    this->replayPath = this->arguments.isSet("replay") ? this->arguments.getOption("replay") : "";
+
+    std::string broadPhase = this->arguments.isSet("broadphase") ? this->arguments.getOption("broadphase") : "grid";
+    if (broadPhase == "grid") {
+        this->broadPhase = Game::Scene::BroadPhaseType::TYPE_SPATIAL_HASH;
+    } else if (broadPhase == "naive") {
+        this->broadPhase = Game::Scene::BroadPhaseType::TYPE_NAIVE;
+    } else {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got unknown `broadphase' value `%s'",
+                broadPhase.c_str());
+        return false;
+    }
+
+    std::string solver = this->arguments.isSet("solver") ? this->arguments.getOption("solver") : "substep";
+    if (solver == "substep") {
+        this->solver = Game::Scene::SolverType::TYPE_SUBSTEP;
+    } else if (solver == "continuous") {
+        this->solver = Game::Scene::SolverType::TYPE_CONTINUOUS;
+    } else {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got unknown `solver' value `%s'",
+                solver.c_str());
+        return false;
+    }
+
+    if (this->threads < 1) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got invalid `threads' value `%d'", this->threads);
+        return false;
+    }
+
+    float tickRate = this->arguments.isSet("tickrate") ? atof(this->arguments.getOption("tickrate").c_str()) : 0.0f;
+    if (tickRate < 0.0f) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got negative `tickrate' value `%f'", tickRate);
+        return false;
+    }
+
+    if (this->maxTicks < 0) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got negative `ticks' value `%d'", this->maxTicks);
+        return false;
+    }
+
+    if (this->profileFrames < 0) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got negative `profile-frames' value `%d'",
+                this->profileFrames);
+        return false;
+    }
+
+    if (this->arguments.isSet("stress")) {
+        Game::StressTest::Counts counts;
+        std::string stress = this->arguments.getOption("stress");
+        if (sscanf(stress.c_str(), "%d,%d,%d,%d", &counts.blocks, &counts.weapons, &counts.packs,
+                &counts.players) != 4 || counts.blocks < 0 || counts.weapons < 0 || counts.packs < 0 ||
+                counts.players < 0) {
+            Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got invalid `stress' value `%s'",
+                    stress.c_str());
+            return false;
+        }
+
+        this->stressSteps = this->arguments.isSet("stress-steps") ?
+                atoi(this->arguments.getOption("stress-steps").c_str()) : 5;
+        if (this->stressSteps < 1) {
+            Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Got invalid `stress-steps' value `%d'",
+                    this->stressSteps);
+            return false;
+        }
+
+        // Ticks measure every step instead of the whole run
+        this->stressTicks = (this->maxTicks > 0) ? this->maxTicks : STRESS_TICKS;
+        this->maxTicks = 0;
+        this->stressTest.reset(new Game::StressTest(counts));
+    }
+
+    if (!this->recordPath.empty() && !this->replayPath.empty()) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Can't both `record' and `replay'");
+        return false;
+    }
+
+    this->tickTime = (tickRate > 0.0f) ? 1.0f / tickRate : 0.0f;
+    return true;
+}
+
+bool PolandBall::initInput() {
+    Utils::InputLog::Settings settings;
+
+    if (!this->replayPath.empty()) {
+        if (!this->inputLog.openForReading(this->replayPath, settings)) {
+            return false;
+        }
+
+        // Solver, broad phase and threads change the outcome as much as the input does
+        this->seed = settings.seed;
+        this->solver = static_cast<Game::Scene::SolverType>(settings.solver);
+        this->broadPhase = static_cast<Game::Scene::BroadPhaseType>(settings.broadPhase);
+        this->threads = settings.threads;
+
+        // Segments are generated from the scene seed, the same ones come back at the same ticks
+        if (settings.stressSteps > 0 && settings.stressTicks > 0) {
+            Game::StressTest::Counts counts = {
+                settings.stressBlocks, settings.stressWeapons, settings.stressPacks, settings.stressPlayers
+            };
+            this->stressSteps = settings.stressSteps;
+            this->stressTicks = settings.stressTicks;
+            this->stressTest.reset(new Game::StressTest(counts));
+        } else {
+            this->stressTest.reset();
+        }
+
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Replaying `%s'", this->replayPath.c_str());
+    } else if (!this->recordPath.empty()) {
+        settings.seed = this->seed;
+        settings.solver = this->solver;
+        settings.broadPhase = this->broadPhase;
+        settings.threads = this->threads;
+        settings.stressBlocks = 0;
+        settings.stressWeapons = 0;
+        settings.stressPacks = 0;
+        settings.stressPlayers = 0;
+        settings.stressSteps = 0;
+        settings.stressTicks = 0;
+
+        if (this->stressTest != nullptr) {
+            const Game::StressTest::Counts& counts = this->stressTest->getCounts();
+            settings.stressBlocks = counts.blocks;
+            settings.stressWeapons = counts.weapons;
+            settings.stressPacks = counts.packs;
+            settings.stressPlayers = counts.players;
+            settings.stressSteps = this->stressSteps;
+            settings.stressTicks = this->stressTicks;
+        }
+
+        if (!this->inputLog.openForWriting(this->recordPath, settings)) {
+            return false;
+        }
+
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Recording to `%s'", this->recordPath.c_str());
+    }
 
     return true;
 }
@@ -255,17 +497,54 @@ bool PolandBall::initOpenGL() {
     glViewport(0, 0, this->width, this->height);
     glLineWidth(0.5f);
 
+    if (!Opengl::Sprite::createQuad()) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Failed to create the sprite quad");
+        return false;
+    }
+
     return true;
 }
 
 bool PolandBall::initScene() {
     this->scene = std::shared_ptr<Game::Scene>(new Game::Scene());
+    this->scene->setBroadPhaseType(this->broadPhase);
+    this->scene->setSolverType(this->solver);
+    this->scene->setThreads(this->threads);
+    this->scene->setSeed(this->seed);
+
+    // Small sprites of every kind share atlas pages and so batches, blocks and backgrounds keep their own
+    auto& resourceCache = Game::EntityFactory::getInstance().getResourceCache();
+    if (!this->headless && !resourceCache->buildAtlas({
+        "assets/players/turkey.asset",
+        "assets/weapons/m4a1.asset",
+        "assets/weapons/ak74.asset",
+        "assets/weapons/m1911.asset",
+        "assets/weapons/beretta92.asset",
+        "assets/weapons/wrench.asset",
+        "assets/weapons/knife.asset",
+        "assets/items/pack_primary_ammo.asset",
+        "assets/items/pack_secondary_ammo.asset",
+        "assets/items/pack_health.asset",
+        "assets/items/pack_armor.asset",
+        "assets/ui/slot_empty.asset",
+        "assets/ui/border_weapon.asset",
+        "assets/ui/shield_armor.asset",
+        "assets/ui/shield_health.asset",
+        "assets/ui/cursor_aim.asset"
+    })) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Failed to build the texture atlas");
+        return false;
+    }
+
+    this->scene->setBatchEffect(resourceCache->loadEffect("shaders/sprite.shader"),
+            resourceCache->loadEffect("shaders/batch.shader"));
 
     Game::Camera& camera = this->scene->getCamera();
     camera.setProjectionType(Game::Camera::TYPE_ORTHOGRAPHIC);
     camera.setAspectRatio(this->width / (this->height / 1.0f));
     camera.setNearPlane(-2.5f);
     camera.setFarPlane(2.5f);
+    this->unitPixels = camera.getProjection().get(1, 1) * this->height / 2.0f;
 
     //-----------------
     auto backgroundEntity = Game::EntityFactory::getInstance().createBlock("assets/backgrounds/sunny.asset");
@@ -397,25 +676,19 @@ bool PolandBall::initScene() {
     this->scene->addEntity(pack_armor);
 
     //-----------------
-    this->player->positionChanged.connect(
-            std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-            backgroundEntity, std::placeholders::_1));
-    this->player->positionChanged.connect(
-            std::bind(static_cast<void(Game::Camera::*)(const Math::Vec3&)>(&Game::Camera::setPosition),
-            &camera, std::placeholders::_1));
+    backgroundEntity->attachTo(this->player->getHandle());
+    this->scene->setCameraTarget(this->player->getHandle());
+
+    if (this->stressTest != nullptr && !this->stressTest->populate(*this->scene)) {
+        return false;
+    }
 
     return true;
 }
 
 bool PolandBall::initUi() {
-    Math::Mat4 ndc;
-    ndc.set(0, 0, 2.0f / (this->width / 1.0f));
-    ndc.set(0, 3, -1.0f);
-    ndc.set(1, 1, -2.0f / (this->height / 1.0f));
-    ndc.set(1, 3, 1.0f);
-
-    Math::Mat4 world(this->scene->getCamera().getProjection());
-    world.invert();
+    // Pixels from the bottom left corner, widgets keep their world size
+    this->scene->setViewport(this->width, this->height);
 
     //-----------------
     this->emptySlot = Game::EntityFactory::getInstance().createWidget("assets/ui/slot_empty.asset");
@@ -427,64 +700,64 @@ bool PolandBall::initUi() {
     auto& primaryWeapon = this->weapons[Game::Weapon::WeaponSlot::SLOT_PRIMARY];
 
     primaryWeapon.first = Game::EntityFactory::getInstance().createWidget("assets/ui/slot_empty.asset");
-    Math::Vec4 primaryWeaponOrigin = (world * ndc) * Math::Vec4(40.0f, 40.0f, 0.0f, 1.0f);
-    primaryWeapon.first->setOrigin(primaryWeaponOrigin.extractVec3());
-    this->scene->addEntity(primaryWeapon.first);
+    primaryWeapon.first->scale(this->unitPixels);
+    primaryWeapon.first->setPosition(40.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(primaryWeapon.first);
 
     auto primaryWeaponBorder = Game::EntityFactory::getInstance().createWidget("assets/ui/border_weapon.asset");
     if (primaryWeaponBorder == nullptr) {
         return false;
     }
 
-    primaryWeaponBorder->setOrigin(primaryWeaponOrigin.extractVec3());
-    this->scene->addEntity(primaryWeaponBorder);
+    primaryWeaponBorder->scale(this->unitPixels);
+    primaryWeaponBorder->setPosition(40.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(primaryWeaponBorder);
 
     primaryWeapon.second = Game::EntityFactory::getInstance().createLabel("dejavu-sans", 14);
-    Math::Vec4 primaryLabelOrigin = (world * ndc) * Math::Vec4(40.0f, 80.0f, 0.0f, 1.0f);
-    primaryWeapon.second->setOrigin(primaryLabelOrigin.extractVec3());
-    this->scene->addEntity(primaryWeapon.second);
+    primaryWeapon.second->setPosition(40.0f, this->height - 80.0f, 0.0f);
+    this->scene->addOverlay(primaryWeapon.second);
 
     //-----------------
     auto& secondaryWeapon = this->weapons[Game::Weapon::WeaponSlot::SLOT_SECONDARY];
 
     secondaryWeapon.first = Game::EntityFactory::getInstance().createWidget("assets/ui/slot_empty.asset");
-    Math::Vec4 secondaryWeaponOrigin = (world * ndc) * Math::Vec4(110.0f, 40.0f, 0.0f, 1.0f);
-    secondaryWeapon.first->setOrigin(secondaryWeaponOrigin.extractVec3());
-    this->scene->addEntity(secondaryWeapon.first);
+    secondaryWeapon.first->scale(this->unitPixels);
+    secondaryWeapon.first->setPosition(110.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(secondaryWeapon.first);
 
     auto secondaryWeaponBorder = Game::EntityFactory::getInstance().createWidget("assets/ui/border_weapon.asset");
     if (secondaryWeaponBorder == nullptr) {
         return false;
     }
 
-    secondaryWeaponBorder->setOrigin(secondaryWeaponOrigin.extractVec3());
-    this->scene->addEntity(secondaryWeaponBorder);
+    secondaryWeaponBorder->scale(this->unitPixels);
+    secondaryWeaponBorder->setPosition(110.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(secondaryWeaponBorder);
 
     secondaryWeapon.second = Game::EntityFactory::getInstance().createLabel("dejavu-sans", 14);
-    Math::Vec4 secondaryLabelOrigin = (world * ndc) * Math::Vec4(110.0f, 80.0f, 0.0f, 1.0f);
-    secondaryWeapon.second->setOrigin(secondaryLabelOrigin.extractVec3());
-    this->scene->addEntity(secondaryWeapon.second);
+    secondaryWeapon.second->setPosition(110.0f, this->height - 80.0f, 0.0f);
+    this->scene->addOverlay(secondaryWeapon.second);
 
     //-----------------
     auto& meeleWeapon = this->weapons[Game::Weapon::WeaponSlot::SLOT_MEELE];
 
     meeleWeapon.first = Game::EntityFactory::getInstance().createWidget("assets/ui/slot_empty.asset");
-    Math::Vec4 meeleWeaponOrigin = (world * ndc) * Math::Vec4(180.0f, 40.0f, 0.0f, 1.0f);
-    meeleWeapon.first->setOrigin(meeleWeaponOrigin.extractVec3());
-    this->scene->addEntity(meeleWeapon.first);
+    meeleWeapon.first->scale(this->unitPixels);
+    meeleWeapon.first->setPosition(180.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(meeleWeapon.first);
 
     auto meeleWeaponBorder = Game::EntityFactory::getInstance().createWidget("assets/ui/border_weapon.asset");
     if (meeleWeaponBorder == nullptr) {
         return false;
     }
 
-    meeleWeaponBorder->setOrigin(meeleWeaponOrigin.extractVec3());
-    this->scene->addEntity(meeleWeaponBorder);
+    meeleWeaponBorder->scale(this->unitPixels);
+    meeleWeaponBorder->setPosition(180.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(meeleWeaponBorder);
 
     meeleWeapon.second = Game::EntityFactory::getInstance().createLabel("dejavu-sans", 14);
-    Math::Vec4 meeleLabelOrigin = (world * ndc) * Math::Vec4(180.0f, 80.0f, 0.0f, 1.0f);
-    meeleWeapon.second->setOrigin(meeleLabelOrigin.extractVec3());
-    this->scene->addEntity(meeleWeapon.second);
+    meeleWeapon.second->setPosition(180.0f, this->height - 80.0f, 0.0f);
+    this->scene->addOverlay(meeleWeapon.second);
 
     //-----------------
     auto armorShield = Game::EntityFactory::getInstance().createWidget("assets/ui/shield_armor.asset");
@@ -492,14 +765,13 @@ bool PolandBall::initUi() {
         return false;
     }
 
-    Math::Vec4 armorShieldOrigin = (world * ndc) * Math::Vec4(Math::Vec3(this->width - 40.0f, 40.0f, 0.0f), 1.0f);
-    armorShield->setOrigin(armorShieldOrigin.extractVec3());
-    this->scene->addEntity(armorShield);
+    armorShield->scale(this->unitPixels);
+    armorShield->setPosition(this->width - 40.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(armorShield);
 
     this->armor = Game::EntityFactory::getInstance().createLabel("dejavu-sans", 14);
-    Math::Vec4 armorLabelOrigin = (world * ndc) * Math::Vec4(Math::Vec3(this->width - 40.0f, 80.0f, 0.0f), 1.0f);
-    this->armor->setOrigin(armorLabelOrigin.extractVec3());
-    this->scene->addEntity(this->armor);
+    this->armor->setPosition(this->width - 40.0f, this->height - 80.0f, 0.0f);
+    this->scene->addOverlay(this->armor);
 
     //-----------------
     auto healthShield = Game::EntityFactory::getInstance().createWidget("assets/ui/shield_health.asset");
@@ -507,51 +779,13 @@ bool PolandBall::initUi() {
         return false;
     }
 
-    Math::Vec4 healthShieldOrigin = (world * ndc) * Math::Vec4(Math::Vec3(this->width - 100.0f, 40.0f, 0.0f), 1.0f);
-    healthShield->setOrigin(healthShieldOrigin.extractVec3());
-    this->scene->addEntity(healthShield);
+    healthShield->scale(this->unitPixels);
+    healthShield->setPosition(this->width - 100.0f, this->height - 40.0f, 0.0f);
+    this->scene->addOverlay(healthShield);
 
     this->health = Game::EntityFactory::getInstance().createLabel("dejavu-sans", 14);
-    Math::Vec4 healthLabelOrigin = (world * ndc) * Math::Vec4(Math::Vec3(this->width - 100.0f, 80.0f, 0.0f), 1.0f);
-    this->health->setOrigin(healthLabelOrigin.extractVec3());
-    this->scene->addEntity(this->health);
-
-    //-----------------
-    Game::Camera& camera = this->scene->getCamera();
-
-    for (auto& weapon: this->weapons) {
-        camera.positionChanged.connect(
-            std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-            weapon.first, std::placeholders::_1));
-        camera.positionChanged.connect(
-            std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-            weapon.second, std::placeholders::_1));
-    }
-
-    camera.positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        primaryWeaponBorder, std::placeholders::_1));
-    camera.positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        secondaryWeaponBorder, std::placeholders::_1));
-    camera.positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        meeleWeaponBorder, std::placeholders::_1));
-
-    //-----------------
-    camera.positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        healthShield, std::placeholders::_1));
-    camera.positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        armorShield, std::placeholders::_1));
-
-    camera.positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        this->health, std::placeholders::_1));
-    camera.positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        this->armor, std::placeholders::_1));
+    this->health->setPosition(this->width - 100.0f, this->height - 80.0f, 0.0f);
+    this->scene->addOverlay(this->health);
 
     //-----------------
     this->cursor = Game::EntityFactory::getInstance().createWidget("assets/ui/cursor_aim.asset");
@@ -559,76 +793,213 @@ bool PolandBall::initUi() {
         return false;
     }
 
-    this->scene->addEntity(this->cursor);
-
-    //-----------------
-    this->player->positionChanged.connect(
-        std::bind(static_cast<void(Game::Entity::*)(const Math::Vec3&)>(&Game::Entity::setPosition),
-        this->cursor, std::placeholders::_1));
+    this->cursor->scale(this->unitPixels);
+    this->cursor->setPosition(this->width / 2.0f, this->height / 2.0f, 0.0f);
+    this->scene->addOverlay(this->cursor);
 
     return true;
 }
 
+void PolandBall::onFrameEnd(float frameTime) {
+    this->frames++;
+    if (this->frames == this->profileFrames) {
+        this->dumpProfile();
+    }
+
+    if (this->stressTest == nullptr) {
+        return;
+    }
+
+    this->stressTest->addSample(frameTime);
+}
+
+void PolandBall::dumpProfile() {
+#ifdef POLANDBALL_PROFILER
+    Utils::Profiler::getInstance().dump("polandball.trace.json");
+#else
+    Utils::Logger::getInstance().log(Utils::Logger::LOG_WARNING, "Built without POLANDBALL_PROFILER, no trace to dump");
+#endif
+}
+
 void PolandBall::onMouseMotion(SDL_MouseMotionEvent& event) {
-    Math::Mat4 ndc;
-    ndc.set(0, 0, 2.0f / (this->width / 1.0f));
-    ndc.set(0, 3, -1.0f);
-    ndc.set(1, 1, -2.0f / (this->height / 1.0f));
-    ndc.set(1, 3, 1.0f);
-
-    Math::Mat4 world(this->scene->getCamera().getProjection());
-    world.invert();
-
-    Math::Vec4 cursorPosition = (world * ndc) * Math::Vec4(event.x, event.y, 0.0f, 1.0f);
-    this->cursor->setOrigin(cursorPosition.extractVec3());
-    this->player->aimAt(cursorPosition.extractVec3());
+    // World offset from the camera, that is from the player it follows
+    this->pendingCursor = Math::Vec3((event.x - this->width / 2.0f) / this->unitPixels,
+                                     (this->height / 2.0f - event.y) / this->unitPixels, 0.0f);
+    this->pendingButtons |= Utils::InputLog::BUTTON_AIM;
 }
 
 void PolandBall::onMouseButton(SDL_MouseButtonEvent& event) {
     if (event.button == 0 && event.state == SDL_PRESSED) {
-        this->player->shoot();
+        this->pendingButtons |= Utils::InputLog::BUTTON_CLICK;
     }
 }
 
 void PolandBall::onIdle() {
+    PROFILE_ZONE("PolandBall::onIdle");
+
+    if (this->tickTime == 0.0f) {
+        this->onTick(this->frameTime);
+        this->updateUi();
+        this->scene->render();
+        return;
+    }
+
+    this->accumulator += this->frameTime;
+
+    int ticks = 0;
+    while (this->accumulator >= this->tickTime && this->running) {
+        if (ticks == MAX_FRAME_TICKS) {
+            // Can't keep up, drop the backlog instead of spiraling down
+            this->accumulator = fmodf(this->accumulator, this->tickTime);
+            break;
+        }
+
+        this->onTick(this->tickTime);
+        this->accumulator -= this->tickTime;
+        ticks++;
+    }
+
+    this->updateUi();
+    this->scene->render(this->accumulator / this->tickTime);
+}
+
+void PolandBall::onTick(float frameTime) {
+    PROFILE_ZONE("PolandBall::onTick");
+
+    Utils::InputFrame frame;
+
+    if (!this->replayPath.empty()) {
+        // Recorded frame times replace ours, whatever the rate we replay at
+        if (!this->inputLog.read(frame)) {
+            Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Replay finished");
+            this->running = false;
+            return;
+        }
+
+        if (!this->headless && SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_ESCAPE] > 0) {
+            this->running = false;
+        }
+    } else {
+        this->readInput(frame, frameTime);
+        if (this->inputLog.isOpen()) {
+            this->inputLog.write(frame);
+        }
+    }
+
+    this->applyInput(frame);
+    if (this->stressTest != nullptr) {
+        this->stressTest->think(*this->scene, frame.frameTime);
+    }
+
+    this->scene->update(frame.frameTime, this->frameStep);
+
+    this->ticks++;
+    this->simulatedTime += frame.frameTime;
+
+    // On ticks rather than frames, replays must grow the level at the same point of the simulation
+    if (this->stressTest != nullptr && this->ticks % this->stressTicks == 0) {
+        this->stressTest->report(*this->scene);
+
+        if (this->stressTest->getStep() == this->stressSteps || !this->stressTest->populate(*this->scene)) {
+            this->running = false;
+        }
+    }
+}
+
+void PolandBall::readInput(Utils::InputFrame& frame, float frameTime) {
+    frame.frameTime = frameTime;
+    frame.buttons = this->pendingButtons;
+    frame.cursorX = this->pendingCursor.get(Math::Vec3::X);
+    frame.cursorY = this->pendingCursor.get(Math::Vec3::Y);
+    this->pendingButtons = 0;
+
+    if (this->headless) {
+        return;  // Nothing to poll without a window
+    }
+
     const Uint8* keyStates = SDL_GetKeyboardState(nullptr);
 
     if (keyStates[SDL_SCANCODE_ESCAPE] > 0) {
-        this->running = false;
+        frame.buttons |= Utils::InputLog::BUTTON_QUIT;
     }
     if (keyStates[SDL_SCANCODE_RIGHT] > 0) {
-        this->player->setState(Game::Player::PlayerState::STATE_RIGHT_STEP);
+        frame.buttons |= Utils::InputLog::BUTTON_RIGHT;
     }
     if (keyStates[SDL_SCANCODE_LEFT] > 0) {
-        this->player->setState(Game::Player::PlayerState::STATE_LEFT_STEP);
+        frame.buttons |= Utils::InputLog::BUTTON_LEFT;
     }
     if (keyStates[SDL_SCANCODE_UP] > 0) {
-        this->player->setState(Game::Player::PlayerState::STATE_JUMP);
+        frame.buttons |= Utils::InputLog::BUTTON_JUMP;
     }
     if (keyStates[SDL_SCANCODE_RETURN] > 0) {
-        this->player->setState(Game::Player::PlayerState::STATE_DROP_WEAPON);
+        frame.buttons |= Utils::InputLog::BUTTON_DROP;
     }
     if (keyStates[SDL_SCANCODE_1] > 0) {
-        this->player->activateSlot(Game::Weapon::WeaponSlot::SLOT_PRIMARY);
+        frame.buttons |= Utils::InputLog::BUTTON_PRIMARY;
     }
     if (keyStates[SDL_SCANCODE_2] > 0) {
-        this->player->activateSlot(Game::Weapon::WeaponSlot::SLOT_SECONDARY);
+        frame.buttons |= Utils::InputLog::BUTTON_SECONDARY;
     }
     if (keyStates[SDL_SCANCODE_3] > 0) {
-        this->player->activateSlot(Game::Weapon::WeaponSlot::SLOT_MEELE);
+        frame.buttons |= Utils::InputLog::BUTTON_MEELE;
     }
 
     Uint32 mouseState = SDL_GetMouseState(nullptr, nullptr);
 
     if ((mouseState & SDL_BUTTON_LMASK) > 0) {
+        frame.buttons |= Utils::InputLog::BUTTON_SHOOT;
+    }
+}
+
+void PolandBall::applyInput(const Utils::InputFrame& frame) {
+    if (frame.buttons & Utils::InputLog::BUTTON_QUIT) {
+        this->running = false;
+    }
+    if (frame.buttons & Utils::InputLog::BUTTON_RIGHT) {
+        this->player->setState(Game::Player::PlayerState::STATE_RIGHT_STEP);
+    }
+    if (frame.buttons & Utils::InputLog::BUTTON_LEFT) {
+        this->player->setState(Game::Player::PlayerState::STATE_LEFT_STEP);
+    }
+    if (frame.buttons & Utils::InputLog::BUTTON_JUMP) {
+        this->player->setState(Game::Player::PlayerState::STATE_JUMP);
+    }
+    if (frame.buttons & Utils::InputLog::BUTTON_DROP) {
+        this->player->setState(Game::Player::PlayerState::STATE_DROP_WEAPON);
+    }
+    if (frame.buttons & Utils::InputLog::BUTTON_PRIMARY) {
+        this->player->activateSlot(Game::Weapon::WeaponSlot::SLOT_PRIMARY);
+    }
+    if (frame.buttons & Utils::InputLog::BUTTON_SECONDARY) {
+        this->player->activateSlot(Game::Weapon::WeaponSlot::SLOT_SECONDARY);
+    }
+    if (frame.buttons & Utils::InputLog::BUTTON_MEELE) {
+        this->player->activateSlot(Game::Weapon::WeaponSlot::SLOT_MEELE);
+    }
+
+    if (frame.buttons & Utils::InputLog::BUTTON_AIM) {
+        Math::Vec3 cursorPosition(frame.cursorX, frame.cursorY, 0.0f);
+        if (this->cursor != nullptr) {
+            this->cursor->setPosition(this->width / 2.0f + frame.cursorX * this->unitPixels,
+                                      this->height / 2.0f + frame.cursorY * this->unitPixels, 0.0f);
+        }
+
+        this->player->aimAt(cursorPosition);
+    }
+
+    if (frame.buttons & (Utils::InputLog::BUTTON_SHOOT | Utils::InputLog::BUTTON_CLICK)) {
         this->player->shoot();
     }
+}
+
+void PolandBall::updateUi() {
+    PROFILE_ZONE("PolandBall::updateUi");
 
     std::stringstream text;
     int weaponAmmo = 0;
 
     for (int slot = 0; slot < 3; slot++) {
-        auto& weapon = this->player->getWeapon(static_cast<Game::Weapon::WeaponSlot>(slot));
+        auto weapon = this->player->getWeapon(static_cast<Game::Weapon::WeaponSlot>(slot));
         auto weaponSprite = std::dynamic_pointer_cast<Opengl::Sprite>(this->weapons[slot].first->getPrimitive());
 
         if (weapon != nullptr) {
@@ -660,9 +1031,6 @@ void PolandBall::onIdle() {
     text.str("");
     text << this->player->getArmor();
     this->armor->setText(text.str());
-
-    this->scene->update(this->frameTime, this->frameStep);
-    this->scene->render();
 }
 
 }  // namespace PolandBall
@@ -29,9 +29,13 @@
 #include "Scene.h"
 #include "NonCopyable.h"
 #include "ArgumentParser.h"
+#include "InputLog.h"
+#include "StressTest.h"
 
 #include <SDL2/SDL_events.h>
+#include <Vec3.h>
 #include <memory>
+#include <string>
 #include <utility>
 
 namespace PolandBall {
@@ -47,18 +51,33 @@ public:
     int exec();
 
 private:
+    enum {
+        MAX_FRAME_TICKS = 5,  // Fixed ticks simulated per rendered frame at most
+        DEFAULT_SEED = 0x5EED,
+        STRESS_TICKS = 300  // Ticks simulated per stress step by default
+    };
+
     bool initialize();
     void shutdown();
 
     bool parseCLI();
     bool initSDL();
     bool initOpenGL();
+    bool initInput();
     bool initScene();
     bool initUi();
 
+    void runHeadless();
+    void onFrameEnd(float frameTime);
+    void dumpProfile();
+
     void onMouseMotion(SDL_MouseMotionEvent& event);
     void onMouseButton(SDL_MouseButtonEvent& event);
     void onIdle();
+    void onTick(float frameTime);
+    void readInput(Utils::InputFrame& frame, float frameTime);
+    void applyInput(const Utils::InputFrame& frame);
+    void updateUi();
 
     SDL_Window* window;
     SDL_GLContext context;
@@ -66,11 +85,11 @@ private:
 
     std::shared_ptr<Game::Scene> scene;
     std::shared_ptr<Game::Player> player;
-    std::shared_ptr<Game::Entity> cursor;
+    std::shared_ptr<Game::Widget> cursor;
 
     // Requires sync if Weapon::WeaponSlot is updated
-    std::pair<std::shared_ptr<Game::Entity>, std::shared_ptr<Game::Label>> weapons[3];
-    std::shared_ptr<Game::Entity> emptySlot;
+    std::pair<std::shared_ptr<Game::Widget>, std::shared_ptr<Game::Label>> weapons[3];
+    std::shared_ptr<Game::Widget> emptySlot;
     std::shared_ptr<Game::Label> health;
     std::shared_ptr<Game::Label> armor;
 
@@ -79,12 +98,36 @@ private:
 
     int width;
     int height;
+    float unitPixels;  // Screen pixels per world unit
     float maxFps;
     bool vsync;
+    bool headless;  // No window nor GL context, simulation only
+    int maxTicks;   // Headless run length, 0 runs until killed
+
+    Utils::InputLog inputLog;
+    std::string recordPath;
+    std::string replayPath;
+    unsigned int seed;
+    int ticks;                   // Simulated since start
+    int frames;                  // Rendered since start, ticks when headless
+    int profileFrames;           // Frames before the profiler trace is dumped, 0 never
+    float simulatedTime;
+    unsigned int pendingButtons; // Event driven input not yet consumed by a tick
+    Math::Vec3 pendingCursor;
+
+    std::unique_ptr<Game::StressTest> stressTest;  // nullptr unless --stress
+    int stressSteps;
+    int stressTicks;
+
+    Game::Scene::BroadPhaseType broadPhase;
+    Game::Scene::SolverType solver;
+    int threads;
 
     bool running;
     float frameTime;
     float frameStep;
+    float tickTime;     // Fixed simulation step, 0 when following the frame rate
+    float accumulator;  // Frame time not yet simulated
 };
 
 }  // namespace PolandBall
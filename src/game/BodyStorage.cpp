@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "BodyStorage.h"
+#include "Entity.h"
+#include "Weapon.h"
+
+#include <Vec3.h>
+
+namespace PolandBall {
+
+namespace Game {
+
+void BodyStorage::insert(const std::shared_ptr<Entity>& entity) {
+    if (entity == nullptr || entity->bodyId != -1) {
+        return;
+    }
+
+    entity->bodyId = this->entities.size();
+    this->entities.push_back(entity);
+    this->positionX.push_back(0.0f);
+    this->positionY.push_back(0.0f);
+    this->positionZ.push_back(0.0f);
+    this->speedX.push_back(0.0f);
+    this->speedY.push_back(0.0f);
+    this->speedZ.push_back(0.0f);
+    this->halfWidth.push_back(0.0f);
+    this->halfHeight.push_back(0.0f);
+    this->flags.push_back(0);
+    this->categories.push_back(0);
+    this->collisionMasks.push_back(0);
+    this->blockingMasks.push_back(0);
+    this->restFrames.push_back(0);
+
+    this->gather(entity->bodyId);
+}
+
+void BodyStorage::remove(const Entity* entity) {
+    int id = entity->bodyId;
+    if (id < 0 || id >= this->getSize() || this->entities[id].get() != entity) {
+        return;
+    }
+
+    // Swap with the last body to keep arrays dense
+    int last = this->getSize() - 1;
+    if (id != last) {
+        this->entities[id] = this->entities[last];
+        this->positionX[id] = this->positionX[last];
+        this->positionY[id] = this->positionY[last];
+        this->positionZ[id] = this->positionZ[last];
+        this->speedX[id] = this->speedX[last];
+        this->speedY[id] = this->speedY[last];
+        this->speedZ[id] = this->speedZ[last];
+        this->halfWidth[id] = this->halfWidth[last];
+        this->halfHeight[id] = this->halfHeight[last];
+        this->flags[id] = this->flags[last];
+        this->categories[id] = this->categories[last];
+        this->collisionMasks[id] = this->collisionMasks[last];
+        this->blockingMasks[id] = this->blockingMasks[last];
+        this->restFrames[id] = this->restFrames[last];
+        this->entities[id]->bodyId = id;
+    }
+
+    this->entities.pop_back();
+    this->positionX.pop_back();
+    this->positionY.pop_back();
+    this->positionZ.pop_back();
+    this->speedX.pop_back();
+    this->speedY.pop_back();
+    this->speedZ.pop_back();
+    this->halfWidth.pop_back();
+    this->halfHeight.pop_back();
+    this->flags.pop_back();
+    this->categories.pop_back();
+    this->collisionMasks.pop_back();
+    this->blockingMasks.pop_back();
+    this->restFrames.pop_back();
+
+    const_cast<Entity*>(entity)->bodyId = -1;
+}
+
+void BodyStorage::clear() {
+    for (auto& entity: this->entities) {
+        entity->bodyId = -1;
+    }
+
+    this->entities.clear();
+    this->positionX.clear();
+    this->positionY.clear();
+    this->positionZ.clear();
+    this->speedX.clear();
+    this->speedY.clear();
+    this->speedZ.clear();
+    this->halfWidth.clear();
+    this->halfHeight.clear();
+    this->flags.clear();
+    this->categories.clear();
+    this->collisionMasks.clear();
+    this->blockingMasks.clear();
+    this->restFrames.clear();
+}
+
+void BodyStorage::gather() {
+    for (int id = 0; id < this->getSize(); id++) {
+        this->gather(id);
+    }
+}
+
+void BodyStorage::gather(int id) {
+    auto& entity = this->entities[id];
+
+    this->gatherBounds(id);
+    this->speedX[id] = entity->getSpeed().get(Math::Vec3::X);
+    this->speedY[id] = entity->getSpeed().get(Math::Vec3::Y);
+    this->speedZ[id] = entity->getSpeed().get(Math::Vec3::Z);
+
+    bool collidable = !entity->destroyed && entity->isCollidable();
+    if (collidable && entity->getType() == Entity::EntityType::TYPE_WEAPON) {
+        auto weapon = static_cast<const Weapon*>(entity.get());
+        collidable = (weapon->getState() != Weapon::WeaponState::STATE_PICKED);
+    }
+
+    // Woken up from outside, by setSpeed() for instance
+    if (!entity->sleeping && (this->flags[id] & FLAG_SLEEPING)) {
+        this->restFrames[id] = 0;
+    }
+
+    unsigned char flags = 0;
+    if (collidable) {
+        flags |= FLAG_COLLIDABLE;
+
+        if (entity->sleeping) {
+            flags |= FLAG_SLEEPING;
+        } else if (!entity->isPassive()) {
+            flags |= FLAG_DYNAMIC;
+        }
+    }
+
+    this->flags[id] = flags;
+    this->categories[id] = entity->getCategory();
+    this->collisionMasks[id] = entity->getCollisionMask();
+    this->blockingMasks[id] = entity->getBlockingMask();
+}
+
+void BodyStorage::gatherBounds(int id) {
+    auto& collider = this->entities[id]->getCollider();
+    Math::Vec3 position = collider->getPosition();
+
+    this->positionX[id] = position.get(Math::Vec3::X);
+    this->positionY[id] = position.get(Math::Vec3::Y);
+    this->positionZ[id] = position.get(Math::Vec3::Z);
+    this->halfWidth[id] = collider->getXFactor() * 0.5f;
+    this->halfHeight[id] = collider->getYFactor() * 0.5f;
+}
+
+void BodyStorage::scatter(int id) {
+    auto& entity = this->entities[id];
+
+    entity->setSpeed(Math::Vec3(this->speedX[id], this->speedY[id], this->speedZ[id]));
+    entity->setPosition(this->positionX[id], this->positionY[id], this->positionZ[id]);
+}
+
+void BodyStorage::wake(int id) {
+    if (this->flags[id] & FLAG_SLEEPING) {
+        this->entities[id]->sleeping = false;
+        this->flags[id] &= ~FLAG_SLEEPING;
+        this->restFrames[id] = 0;
+    }
+}
+
+void BodyStorage::sleep(int id) {
+    this->entities[id]->sleeping = true;
+    this->flags[id] = (this->flags[id] & ~FLAG_DYNAMIC) | FLAG_SLEEPING;
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BODYSTORAGE_H
+#define BODYSTORAGE_H
+
+#include "NonCopyable.h"
+#include "Collider.h"
+
+#include <vector>
+#include <memory>
+
+namespace PolandBall {
+
+namespace Game {
+
+class Entity;
+
+// Scene entities' physics state as parallel arrays, indexed by Entity::bodyId
+class BodyStorage: public Common::NonCopyable {
+public:
+    enum BodyFlags {
+        FLAG_COLLIDABLE = 1 << 0,  // Can be collided with
+        FLAG_DYNAMIC = 1 << 1,     // Moved by the solver
+        FLAG_SLEEPING = 1 << 2,    // Collidable but not moved until woken
+        FLAG_RESTING = 1 << 3      // Blocked from below during the last step
+    };
+
+    int getSize() const {
+        return this->entities.size();
+    }
+
+    void insert(const std::shared_ptr<Entity>& entity);
+    void remove(const Entity* entity);
+    void clear();
+
+    // Entities are the source of truth between updates, bodies mirror them while stepping
+    void gather();
+    void gather(int id);
+    void gatherBounds(int id);
+    void scatter(int id);
+
+    void wake(int id);
+    void sleep(int id);
+
+    Collider::Box getBox(int id) const {
+        return { this->positionX[id] - this->halfWidth[id], this->positionX[id] + this->halfWidth[id],
+                 this->positionY[id] - this->halfHeight[id], this->positionY[id] + this->halfHeight[id] };
+    }
+
+private:
+    friend class Scene;
+
+    std::vector<std::shared_ptr<Entity>> entities;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> positionZ;
+    std::vector<float> speedX;
+    std::vector<float> speedY;
+    std::vector<float> speedZ;
+    std::vector<float> halfWidth;   // Signed, the same way collider factors are
+    std::vector<float> halfHeight;
+    std::vector<unsigned char> flags;
+    std::vector<unsigned int> categories;  // Entity collision layers
+    std::vector<unsigned int> collisionMasks;
+    std::vector<unsigned int> blockingMasks;
+    std::vector<int> restFrames;    // Consecutive frames spent resting and slow
+};
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // BODYSTORAGE_H
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Bot.h"
+#include "Scene.h"
+#include "Player.h"
+
+namespace PolandBall {
+
+namespace Game {
+
+void Bot::think(Scene& scene, float frameTime) {
+    Entity* entity = scene.getEntity(this->player);
+    if (entity == nullptr || entity->getType() != Entity::EntityType::TYPE_PLAYER) {
+        return;
+    }
+
+    Player* player = static_cast<Player*>(entity);
+
+    this->decisionTime -= frameTime;
+    if (this->decisionTime <= 0.0f) {
+        this->decisionTime = 0.5f + scene.getRandom() * 1.5f;
+        this->direction = (scene.getRandom() < 0.5f) ? -1.0f : 1.0f;
+        this->aimHeight = scene.getRandom() - 0.5f;
+        this->jumping = (scene.getRandom() < 0.3f);
+        this->firing = (scene.getRandom() < 0.4f);
+    }
+
+    player->setState((this->direction > 0.0f) ? Player::PlayerState::STATE_RIGHT_STEP :
+                                                Player::PlayerState::STATE_LEFT_STEP);
+    if (this->jumping) {
+        player->setState(Player::PlayerState::STATE_JUMP);
+    }
+
+    player->aimAt(Math::Vec3(this->direction, this->aimHeight, 0.0f));
+    if (this->firing) {
+        player->shoot();
+    }
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
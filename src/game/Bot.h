@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BOT_H
+#define BOT_H
+
+#include "HandleTable.h"
+
+namespace PolandBall {
+
+namespace Game {
+
+class Scene;
+
+// Drives a player around at random: walks, jumps and fires now and then
+class Bot {
+public:
+    Bot(EntityHandle player) {
+        this->player = player;
+        this->decisionTime = 0.0f;
+        this->direction = 1.0f;
+        this->aimHeight = 0.0f;
+        this->jumping = false;
+        this->firing = false;
+    }
+
+    // Does nothing once the player is gone
+    void think(Scene& scene, float frameTime);
+
+private:
+    EntityHandle player;
+    float decisionTime;  // Until the next change of mind
+    float direction;
+    float aimHeight;
+    bool jumping;
+    bool firing;
+};
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // BOT_H
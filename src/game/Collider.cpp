@@ -22,7 +22,13 @@
 
 #include "Collider.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cfloat>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace PolandBall {
 
@@ -33,48 +39,50 @@ Collider::CollideSide Collider::collides(const std::unique_ptr<Collider>& anothe
         return SIDE_NONE;
     }
 
-    auto ourBox = this->getCollideBox();
-    auto anotherBox = another->getCollideBox();
+    return Collider::classify(this->getBox(), another->getBox());
+}
+
+Collider::CollideSide Collider::classify(const Box& ourBox, const Box& anotherBox) {
     float width = 0, height = 0;
 
     // Their top is inside us
-    if ((anotherBox[0].get(Math::Vec3::Y) <= ourBox[0].get(Math::Vec3::Y)) &&
-            (anotherBox[0].get(Math::Vec3::Y) >= ourBox[3].get(Math::Vec3::Y)) &&
-            !((anotherBox[3].get(Math::Vec3::Y) <= ourBox[0].get(Math::Vec3::Y)) &&
-            (anotherBox[3].get(Math::Vec3::Y) >= ourBox[3].get(Math::Vec3::Y)))) {
+    if ((anotherBox.top <= ourBox.top) &&
+            (anotherBox.top >= ourBox.bottom) &&
+            !((anotherBox.bottom <= ourBox.top) &&
+            (anotherBox.bottom >= ourBox.bottom))) {
 
-        bool topRightInside = this->vertexInsideBox(anotherBox[0], ourBox);
-        bool topLeftInside = this->vertexInsideBox(anotherBox[1], ourBox);
+        bool topRightInside = Collider::vertexInsideBox(anotherBox.right, anotherBox.top, ourBox);
+        bool topLeftInside = Collider::vertexInsideBox(anotherBox.left, anotherBox.top, ourBox);
 
         if (topLeftInside && topRightInside) {
             return SIDE_BOTTOM;
         }
 
         if (topLeftInside) {
-            width = ourBox[3].get(Math::Vec3::X) - anotherBox[1].get(Math::Vec3::X);
-            height = anotherBox[1].get(Math::Vec3::Y) - ourBox[3].get(Math::Vec3::Y);
+            width = ourBox.right - anotherBox.left;
+            height = anotherBox.top - ourBox.bottom;
             return (width > height) ? SIDE_BOTTOM : SIDE_RIGHT;
         }
 
         if (topRightInside) {
-            width = anotherBox[0].get(Math::Vec3::X) - ourBox[2].get(Math::Vec3::X);
-            height = anotherBox[0].get(Math::Vec3::Y) - ourBox[2].get(Math::Vec3::Y);
+            width = anotherBox.right - ourBox.left;
+            height = anotherBox.top - ourBox.bottom;
             return (width > height) ? SIDE_BOTTOM : SIDE_LEFT;
         }
 
         if (!topLeftInside && !topRightInside &&
-                anotherBox[1].get(Math::Vec3::X) <= ourBox[1].get(Math::Vec3::X) &&
-                anotherBox[0].get(Math::Vec3::X) >= ourBox[0].get(Math::Vec3::X)) {
+                anotherBox.left <= ourBox.left &&
+                anotherBox.right >= ourBox.right) {
             return SIDE_BOTTOM;
         }
     // Their bottom is inside us
-    } else if ((anotherBox[3].get(Math::Vec3::Y) <= ourBox[0].get(Math::Vec3::Y)) &&
-            (anotherBox[3].get(Math::Vec3::Y) >= ourBox[3].get(Math::Vec3::Y)) &&
-            !((anotherBox[0].get(Math::Vec3::Y) <= ourBox[0].get(Math::Vec3::Y)) &&
-            (anotherBox[0].get(Math::Vec3::Y) >= ourBox[3].get(Math::Vec3::Y)))) {
+    } else if ((anotherBox.bottom <= ourBox.top) &&
+            (anotherBox.bottom >= ourBox.bottom) &&
+            !((anotherBox.top <= ourBox.top) &&
+            (anotherBox.top >= ourBox.bottom))) {
 
-        bool bottomRightInside = this->vertexInsideBox(anotherBox[3], ourBox);
-        bool bottomLeftInside = this->vertexInsideBox(anotherBox[2], ourBox);
+        bool bottomRightInside = Collider::vertexInsideBox(anotherBox.right, anotherBox.bottom, ourBox);
+        bool bottomLeftInside = Collider::vertexInsideBox(anotherBox.left, anotherBox.bottom, ourBox);
 
         // Both inside (narrorer) or both outside (wider)
         if (bottomLeftInside && bottomRightInside) {
@@ -82,48 +90,48 @@ Collider::CollideSide Collider::collides(const std::unique_ptr<Collider>& anothe
         }
 
         if (bottomLeftInside) {
-            width = ourBox[0].get(Math::Vec3::X) - anotherBox[2].get(Math::Vec3::X);
-            height = ourBox[0].get(Math::Vec3::Y) - anotherBox[2].get(Math::Vec3::Y);
+            width = ourBox.right - anotherBox.left;
+            height = ourBox.top - anotherBox.bottom;
             return (width > height) ? SIDE_TOP : SIDE_RIGHT;
         }
 
         if (bottomRightInside) {
-            width = anotherBox[3].get(Math::Vec3::X) - ourBox[1].get(Math::Vec3::X);
-            height = ourBox[1].get(Math::Vec3::Y) - anotherBox[3].get(Math::Vec3::Y);
+            width = anotherBox.right - ourBox.left;
+            height = ourBox.top - anotherBox.bottom;
             return (width > height) ? SIDE_TOP : SIDE_LEFT;
         }
 
         if (!bottomLeftInside && !bottomRightInside &&
-                anotherBox[2].get(Math::Vec3::X) <= ourBox[2].get(Math::Vec3::X) &&
-                anotherBox[3].get(Math::Vec3::X) >= ourBox[3].get(Math::Vec3::X)) {
+                anotherBox.left <= ourBox.left &&
+                anotherBox.right >= ourBox.right) {
             return SIDE_TOP;
         }
     // Their right is inside us
-    } else if ((anotherBox[0].get(Math::Vec3::X) <= ourBox[0].get(Math::Vec3::X)) &&
-            (anotherBox[0].get(Math::Vec3::X) >= ourBox[1].get(Math::Vec3::X)) &&
-            !((anotherBox[1].get(Math::Vec3::X) <= ourBox[0].get(Math::Vec3::X)) &&
-            (anotherBox[1].get(Math::Vec3::X) >= ourBox[1].get(Math::Vec3::X)))) {
+    } else if ((anotherBox.right <= ourBox.right) &&
+            (anotherBox.right >= ourBox.left) &&
+            !((anotherBox.left <= ourBox.right) &&
+            (anotherBox.left >= ourBox.left))) {
         // Partial intersection is already covered in previous clauses
-        bool rightTopInside = this->vertexInsideBox(anotherBox[0], ourBox);
-        bool rightBottomInside = this->vertexInsideBox(anotherBox[3], ourBox);
+        bool rightTopInside = Collider::vertexInsideBox(anotherBox.right, anotherBox.top, ourBox);
+        bool rightBottomInside = Collider::vertexInsideBox(anotherBox.right, anotherBox.bottom, ourBox);
 
         if (rightBottomInside && rightTopInside) {
             return SIDE_LEFT;
         }
 
         if (!rightBottomInside && !rightTopInside &&
-                anotherBox[0].get(Math::Vec3::Y) >= ourBox[1].get(Math::Vec3::Y) &&
-                anotherBox[3].get(Math::Vec3::Y) <= ourBox[2].get(Math::Vec3::Y)) {
+                anotherBox.top >= ourBox.top &&
+                anotherBox.bottom <= ourBox.bottom) {
             return SIDE_LEFT;
         }
     // Their left is inside us
-    } else if ((anotherBox[1].get(Math::Vec3::X) <= ourBox[0].get(Math::Vec3::X)) &&
-            (anotherBox[1].get(Math::Vec3::X) >= ourBox[1].get(Math::Vec3::X)) &&
-            !((anotherBox[0].get(Math::Vec3::X) <= ourBox[0].get(Math::Vec3::X)) &&
-            (anotherBox[0].get(Math::Vec3::X) >= ourBox[1].get(Math::Vec3::X)))) {
+    } else if ((anotherBox.left <= ourBox.right) &&
+            (anotherBox.left >= ourBox.left) &&
+            !((anotherBox.right <= ourBox.right) &&
+            (anotherBox.right >= ourBox.left))) {
         // Partial intersection is already covered in previous clauses
-        bool leftTopInside = this->vertexInsideBox(anotherBox[1], ourBox);
-        bool leftBottomInside = this->vertexInsideBox(anotherBox[2], ourBox);
+        bool leftTopInside = Collider::vertexInsideBox(anotherBox.left, anotherBox.top, ourBox);
+        bool leftBottomInside = Collider::vertexInsideBox(anotherBox.left, anotherBox.bottom, ourBox);
 
         // Both inside (narrorer) or both outside (wider)
         if (leftBottomInside && leftTopInside) {
@@ -131,8 +139,8 @@ Collider::CollideSide Collider::collides(const std::unique_ptr<Collider>& anothe
         }
 
         if (!leftBottomInside && !leftTopInside &&
-                anotherBox[1].get(Math::Vec3::Y) >= ourBox[0].get(Math::Vec3::Y) &&
-                anotherBox[2].get(Math::Vec3::Y) <= ourBox[0].get(Math::Vec3::Y)) {
+                anotherBox.top >= ourBox.top &&
+                anotherBox.bottom <= ourBox.top) {
             return SIDE_RIGHT;
         }
     }
@@ -140,6 +148,158 @@ Collider::CollideSide Collider::collides(const std::unique_ptr<Collider>& anothe
     return SIDE_NONE;
 }
 
+void Collider::classify(const Box& ourBox, const float* left, const float* right,
+        const float* bottom, const float* top, int count, CollideSide* sides) {
+    int lane = 0;
+
+#ifdef __SSE2__
+    // Same comparisons as the scalar path, branches turned into disjoint lane masks
+    const __m128 ourLeft = _mm_set1_ps(ourBox.left);
+    const __m128 ourRight = _mm_set1_ps(ourBox.right);
+    const __m128 ourBottom = _mm_set1_ps(ourBox.bottom);
+    const __m128 ourTop = _mm_set1_ps(ourBox.top);
+
+    const __m128 allLanes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    const __m128 sideTop = _mm_castsi128_ps(_mm_set1_epi32(SIDE_TOP));
+    const __m128 sideLeft = _mm_castsi128_ps(_mm_set1_epi32(SIDE_LEFT));
+    const __m128 sideBottom = _mm_castsi128_ps(_mm_set1_epi32(SIDE_BOTTOM));
+    const __m128 sideRight = _mm_castsi128_ps(_mm_set1_epi32(SIDE_RIGHT));
+
+    for (; lane + 4 <= count; lane += 4) {
+        __m128 anotherLeft = _mm_loadu_ps(left + lane);
+        __m128 anotherRight = _mm_loadu_ps(right + lane);
+        __m128 anotherBottom = _mm_loadu_ps(bottom + lane);
+        __m128 anotherTop = _mm_loadu_ps(top + lane);
+
+        // Which of their edges lie within our extent
+        __m128 topInside = _mm_and_ps(_mm_cmple_ps(anotherTop, ourTop), _mm_cmpge_ps(anotherTop, ourBottom));
+        __m128 bottomInside = _mm_and_ps(_mm_cmple_ps(anotherBottom, ourTop),
+                _mm_cmpge_ps(anotherBottom, ourBottom));
+        __m128 rightInside = _mm_and_ps(_mm_cmple_ps(anotherRight, ourRight), _mm_cmpge_ps(anotherRight, ourLeft));
+        __m128 leftInside = _mm_and_ps(_mm_cmple_ps(anotherLeft, ourRight), _mm_cmpge_ps(anotherLeft, ourLeft));
+
+        // The four quadrant clauses, each excluding the ones before it
+        __m128 topClause = _mm_andnot_ps(bottomInside, topInside);
+        __m128 bottomClause = _mm_andnot_ps(topInside, bottomInside);
+        __m128 rightClause = _mm_andnot_ps(_mm_or_ps(topClause, bottomClause), _mm_andnot_ps(leftInside, rightInside));
+        __m128 leftClause = _mm_andnot_ps(_mm_or_ps(topClause, bottomClause), _mm_andnot_ps(rightInside, leftInside));
+
+        __m128 bothCorners = _mm_and_ps(leftInside, rightInside);
+        __m128 leftCornerOnly = _mm_andnot_ps(rightInside, leftInside);
+        __m128 rightCornerOnly = _mm_andnot_ps(leftInside, rightInside);
+        __m128 noCorners = _mm_andnot_ps(_mm_or_ps(leftInside, rightInside), allLanes);
+        __m128 wider = _mm_and_ps(_mm_cmple_ps(anotherLeft, ourLeft), _mm_cmpge_ps(anotherRight, ourRight));
+
+        __m128 leftWidth = _mm_sub_ps(ourRight, anotherLeft);
+        __m128 rightWidth = _mm_sub_ps(anotherRight, ourLeft);
+        __m128 topHeight = _mm_sub_ps(anotherTop, ourBottom);
+        __m128 bottomHeight = _mm_sub_ps(ourTop, anotherBottom);
+
+        // Their top is inside us
+        __m128 bottom = _mm_and_ps(topClause, _mm_or_ps(_mm_or_ps(bothCorners, _mm_and_ps(noCorners, wider)),
+                _mm_or_ps(_mm_and_ps(leftCornerOnly, _mm_cmpgt_ps(leftWidth, topHeight)),
+                          _mm_and_ps(rightCornerOnly, _mm_cmpgt_ps(rightWidth, topHeight)))));
+        __m128 right = _mm_and_ps(topClause, _mm_andnot_ps(_mm_cmpgt_ps(leftWidth, topHeight), leftCornerOnly));
+        __m128 left = _mm_and_ps(topClause, _mm_andnot_ps(_mm_cmpgt_ps(rightWidth, topHeight), rightCornerOnly));
+
+        // Their bottom is inside us
+        __m128 top = _mm_and_ps(bottomClause, _mm_or_ps(_mm_or_ps(bothCorners, _mm_and_ps(noCorners, wider)),
+                _mm_or_ps(_mm_and_ps(leftCornerOnly, _mm_cmpgt_ps(leftWidth, bottomHeight)),
+                          _mm_and_ps(rightCornerOnly, _mm_cmpgt_ps(rightWidth, bottomHeight)))));
+        right = _mm_or_ps(right, _mm_and_ps(bottomClause,
+                _mm_andnot_ps(_mm_cmpgt_ps(leftWidth, bottomHeight), leftCornerOnly)));
+        left = _mm_or_ps(left, _mm_and_ps(bottomClause,
+                _mm_andnot_ps(_mm_cmpgt_ps(rightWidth, bottomHeight), rightCornerOnly)));
+
+        // Their right or left is inside us, corners there are our top and bottom edges
+        __m128 bothEdges = _mm_and_ps(topInside, bottomInside);
+        __m128 noEdges = _mm_andnot_ps(_mm_or_ps(topInside, bottomInside), allLanes);
+        __m128 taller = _mm_cmpge_ps(anotherTop, ourTop);
+
+        left = _mm_or_ps(left, _mm_and_ps(rightClause, _mm_or_ps(bothEdges,
+                _mm_and_ps(noEdges, _mm_and_ps(taller, _mm_cmple_ps(anotherBottom, ourBottom))))));
+        right = _mm_or_ps(right, _mm_and_ps(leftClause, _mm_or_ps(bothEdges,
+                _mm_and_ps(noEdges, _mm_and_ps(taller, _mm_cmple_ps(anotherBottom, ourTop))))));
+
+        __m128 result = _mm_or_ps(_mm_or_ps(_mm_and_ps(top, sideTop), _mm_and_ps(left, sideLeft)),
+                                  _mm_or_ps(_mm_and_ps(bottom, sideBottom), _mm_and_ps(right, sideRight)));
+
+        int lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_castps_si128(result));
+
+        for (int i = 0; i < 4; i++) {
+            sides[lane + i] = static_cast<CollideSide>(lanes[i]);
+        }
+    }
+#endif
+
+    for (; lane < count; lane++) {
+        Box anotherBox = { left[lane], right[lane], bottom[lane], top[lane] };
+        sides[lane] = Collider::classify(ourBox, anotherBox);
+    }
+}
+
+float Collider::sweep(const std::unique_ptr<Collider>& another, const Math::Vec3& motion,
+        Math::Vec3& direction) const {
+    if (this == another.get()) {
+        return FLT_MAX;
+    }
+
+    Math::Vec3 ourLowerBound(this->getLowerBound());
+    Math::Vec3 ourUpperBound(this->getUpperBound());
+    Math::Vec3 anotherLowerBound(another->getLowerBound());
+    Math::Vec3 anotherUpperBound(another->getUpperBound());
+
+    float xEntryTime, xExitTime;
+    if (!Collider::sweepAxis(ourLowerBound.get(Math::Vec3::X), ourUpperBound.get(Math::Vec3::X),
+            anotherLowerBound.get(Math::Vec3::X), anotherUpperBound.get(Math::Vec3::X),
+            motion.get(Math::Vec3::X), xEntryTime, xExitTime)) {
+        return FLT_MAX;
+    }
+
+    float yEntryTime, yExitTime;
+    if (!Collider::sweepAxis(ourLowerBound.get(Math::Vec3::Y), ourUpperBound.get(Math::Vec3::Y),
+            anotherLowerBound.get(Math::Vec3::Y), anotherUpperBound.get(Math::Vec3::Y),
+            motion.get(Math::Vec3::Y), yEntryTime, yExitTime)) {
+        return FLT_MAX;
+    }
+
+    // Boxes collide once they overlap along both axes
+    float entryTime = std::max(xEntryTime, yEntryTime);
+    float exitTime = std::min(xExitTime, yExitTime);
+
+    if (entryTime <= 0.0f || entryTime > 1.0f || entryTime > exitTime) {
+        return FLT_MAX;
+    }
+
+    if (xEntryTime > yEntryTime) {
+        direction = Math::Vec3::UNIT_X * ((motion.get(Math::Vec3::X) > 0.0f) ? 1.0f : -1.0f);
+    } else {
+        direction = Math::Vec3::UNIT_Y * ((motion.get(Math::Vec3::Y) > 0.0f) ? 1.0f : -1.0f);
+    }
+
+    return entryTime;
+}
+
+bool Collider::sweepAxis(float ourMin, float ourMax, float anotherMin, float anotherMax, float velocity,
+        float& entryTime, float& exitTime) {
+    if (velocity == 0.0f) {
+        entryTime = -FLT_MAX;
+        exitTime = FLT_MAX;
+        return (ourMax >= anotherMin && ourMin <= anotherMax);
+    }
+
+    if (velocity > 0.0f) {
+        entryTime = (anotherMin - ourMax) / velocity;
+        exitTime = (anotherMax - ourMin) / velocity;
+    } else {
+        entryTime = (anotherMax - ourMin) / velocity;
+        exitTime = (anotherMin - ourMax) / velocity;
+    }
+
+    return true;
+}
+
 }  // namespace Game
 
 }  // namespace PolandBall
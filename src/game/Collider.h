@@ -27,10 +27,8 @@
 #include "Movable.h"
 
 #include <Vec3.h>
-#include <Vec4.h>
-#include <Mat4.h>
-#include <array>
 #include <memory>
+#include <cmath>
 
 namespace PolandBall {
 
@@ -47,81 +45,114 @@ public:
         SIDE_RIGHT
     };
 
-    Collider() {
-        // NOTE: This is the same as Sprite default geometry
-        this->collideBox[0] = Math::Vec3( 0.5f,  0.5f,  0.0f);  // 0  1<--0
-        this->collideBox[1] = Math::Vec3(-0.5f,  0.5f,  0.0f);  // 1  |   ^
-        this->collideBox[2] = Math::Vec3(-0.5f, -0.5f,  0.0f);  // 2  v   |
-        this->collideBox[3] = Math::Vec3( 0.5f, -0.5f,  0.0f);  // 3  2-->3
+    // World-space box edges, left and right swap places for negative factors
+    typedef struct {
+        float left;
+        float right;
+        float bottom;
+        float top;
+    } Box;
+
+    Collider():
+            position(0.0f, 0.0f, 0.0f) {
+        // NOTE: Unit box, the same as Sprite default geometry
+        this->xFactor = 1.0f;
+        this->yFactor = 1.0f;
+        this->zFactor = 1.0f;
+        this->updateBox();
     }
 
     using Movable::setPosition;
 
     void setPosition(const Math::Vec3& position) {
-        this->translation.set(0, 3, position.get(Math::Vec3::X));
-        this->translation.set(1, 3, position.get(Math::Vec3::Y));
-        this->translation.set(2, 3, position.get(Math::Vec3::Z));
+        this->position = position;
+        this->updateBox();
     }
 
     Math::Vec3 getPosition() const {
-        return Math::Vec3(this->translation.get(0, 3),
-                          this->translation.get(1, 3),
-                          this->translation.get(2, 3));
+        return this->position;
     }
 
     void scaleX(float factor) {
-        this->scaling.set(0, 0, factor);
+        this->xFactor = factor;
+        this->updateBox();
     }
 
     void scaleY(float factor) {
-        this->scaling.set(1, 1, factor);
+        this->yFactor = factor;
+        this->updateBox();
     }
 
     void scaleZ(float factor) {
-        this->scaling.set(2, 2, factor);
+        this->zFactor = factor;
     }
 
     float getXFactor() const {
-        return this->scaling.get(0, 0);
+        return this->xFactor;
     }
 
     float getYFactor() const {
-        return this->scaling.get(1, 1);
+        return this->yFactor;
     }
 
     float getZFactor() const {
-        return this->scaling.get(2, 2);
+        return this->zFactor;
+    }
+
+    Math::Vec3 getLowerBound() const {
+        return Math::Vec3(this->position.get(Math::Vec3::X) - fabsf(this->xFactor) * 0.5f,
+                          this->position.get(Math::Vec3::Y) - fabsf(this->yFactor) * 0.5f,
+                          this->position.get(Math::Vec3::Z) - fabsf(this->zFactor) * 0.5f);
+    }
+
+    Math::Vec3 getUpperBound() const {
+        return Math::Vec3(this->position.get(Math::Vec3::X) + fabsf(this->xFactor) * 0.5f,
+                          this->position.get(Math::Vec3::Y) + fabsf(this->yFactor) * 0.5f,
+                          this->position.get(Math::Vec3::Z) + fabsf(this->zFactor) * 0.5f);
+    }
+
+    const Box& getBox() const {
+        return this->box;
     }
 
     CollideSide collides(const std::unique_ptr<Collider>& another) const;
 
-private:
-    std::array<Math::Vec3, 4> getCollideBox() const {
-        std::array<Math::Vec3, 4> realBox;
-        Math::Mat4 transformation = this->translation * this->scaling;
+    // Which side of ourBox anotherBox hits, the very same classification collides() does
+    static CollideSide classify(const Box& ourBox, const Box& anotherBox);
 
-        for (int i = 0; i < 4; i++) {
-            realBox[i] = (transformation * Math::Vec4(this->collideBox[i], 1.0f)).extractVec3();
-        }
+    // classify() against count boxes packed edge by edge, four lanes at a time with SSE2
+    static void classify(const Box& ourBox, const float* left, const float* right,
+            const float* bottom, const float* top, int count, CollideSide* sides);
+
+    // Fraction of motion after which we hit the (still) another collider, FLT_MAX if we don't.
+    // Boxes already touching are contacts rather than impacts, those are left to collides().
+    float sweep(const std::unique_ptr<Collider>& another, const Math::Vec3& motion, Math::Vec3& direction) const;
 
-        return realBox;
+private:
+    static bool sweepAxis(float ourMin, float ourMax, float anotherMin, float anotherMax, float velocity,
+            float& entryTime, float& exitTime);
+
+    // Same edges the unit collide box corners land on after translation * scaling
+    void updateBox() {
+        this->box.left = this->position.get(Math::Vec3::X) + this->xFactor * -0.5f;
+        this->box.right = this->position.get(Math::Vec3::X) + this->xFactor * 0.5f;
+        this->box.bottom = this->position.get(Math::Vec3::Y) + this->yFactor * -0.5f;
+        this->box.top = this->position.get(Math::Vec3::Y) + this->yFactor * 0.5f;
     }
 
-    bool vertexInsideBox(const Math::Vec3& vertex, const std::array<Math::Vec3, 4>& box) const {
-        if (vertex.get(Math::Vec3::X) <= box[0].get(Math::Vec3::X) &&
-                vertex.get(Math::Vec3::X) >= box[1].get(Math::Vec3::X) &&
-                vertex.get(Math::Vec3::Y) <= box[0].get(Math::Vec3::Y) &&
-                vertex.get(Math::Vec3::Y) >= box[3].get(Math::Vec3::Y)) {
+    static bool vertexInsideBox(float x, float y, const Box& box) {
+        if (x <= box.right && x >= box.left && y <= box.top && y >= box.bottom) {
             return true;
         }
 
         return false;
     }
 
-    std::array<Math::Vec3, 4> collideBox;
-
-    Math::Mat4 translation;
-    Math::Mat4 scaling;
+    Math::Vec3 position;
+    float xFactor;
+    float yFactor;
+    float zFactor;
+    Box box;
 };
 
 }  // namespace Game
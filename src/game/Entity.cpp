@@ -21,11 +21,31 @@
  */
 
 #include "Entity.h"
+#include "Scene.h"
 
 namespace PolandBall {
 
 namespace Game {
 
+void Entity::attachTo(EntityHandle parent) {
+    this->parent = parent;
+    this->parentVersion = 0;
+
+    if (this->scene != nullptr) {
+        this->scene->attach(this);
+    }
+}
+
+void Entity::updateBounds() {
+    if (!this->collidable) {
+        return;
+    }
+
+    if (this->scene != nullptr) {
+        this->scene->updateBounds(this);
+    }
+}
+
 }  // namespace Game
 
 }  // namespace PolandBall
@@ -24,6 +24,7 @@
 #define ENTITY_H
 
 #include "Collider.h"
+#include "HandleTable.h"
 #include "Primitive.h"
 #include "RenderEffect.h"
 #include "Texture.h"
@@ -50,13 +51,44 @@ public:
         TYPE_WIDGET    // Last to render
     };
 
+    // Collision categories, one per EntityType by default
+    enum CollisionLayer {
+        LAYER_GENERIC = 1 << TYPE_GENERIC,
+        LAYER_PLAYER = 1 << TYPE_PLAYER,
+        LAYER_WEAPON = 1 << TYPE_WEAPON,
+        LAYER_PACK = 1 << TYPE_PACK,
+        LAYER_WIDGET = 1 << TYPE_WIDGET,
+        LAYER_PICKUP = LAYER_WEAPON | LAYER_PACK,
+        LAYER_ALL = LAYER_GENERIC | LAYER_PLAYER | LAYER_PICKUP | LAYER_WIDGET
+    };
+
+    // Layers reported to onCollision(), pickups do not touch each other
+    static constexpr unsigned int getDefaultCollisionMask(EntityType type) {
+        return (type == TYPE_WEAPON || type == TYPE_PACK) ? LAYER_ALL & ~LAYER_PICKUP : LAYER_ALL;
+    }
+
+    // Layers that stop the movement, pickups are walked through
+    static constexpr unsigned int getDefaultBlockingMask(EntityType type) {
+        return (type == TYPE_PLAYER) ? LAYER_ALL & ~LAYER_PICKUP :
+               (type == TYPE_WEAPON || type == TYPE_PACK) ? LAYER_ALL & ~LAYER_PLAYER : LAYER_ALL;
+    }
+
     Entity():
             collider(new Collider()) {
-        this->type = EntityType::TYPE_GENERIC;
+        this->setType(EntityType::TYPE_GENERIC);
         this->visible = true;
         this->passive = true;
         this->collidable = true;
         this->destroyed = false;
+        this->stationary = false;
+        this->bodyId = -1;
+        this->sleeping = false;
+        this->scene = nullptr;
+        this->handle = HandleTable::NONE;
+        this->parent = HandleTable::NONE;
+        this->transformVersion = 1;
+        this->parentVersion = 0;
+        this->resolving = false;
     }
 
     virtual ~Entity() {}
@@ -66,6 +98,8 @@ public:
     void setPosition(const Math::Vec3& position) {
         this->primitive->setPosition(this->origin + position);
         this->collider->setPosition(this->origin + position);
+        this->transformVersion++;
+        this->updateBounds();
         this->positionChanged(position);
     }
 
@@ -92,16 +126,19 @@ public:
     void scaleX(float factor) {
         this->primitive->scaleX(factor);
         this->collider->scaleX(factor);
+        this->updateBounds();
     }
 
     void scaleY(float factor) {
         this->primitive->scaleY(factor);
         this->collider->scaleY(factor);
+        this->updateBounds();
     }
 
     void scaleZ(float factor) {
         this->primitive->scaleZ(factor);
         this->collider->scaleZ(factor);
+        this->updateBounds();
     }
 
     float getXFactor() const {
@@ -120,6 +157,47 @@ public:
         return this->type;
     }
 
+    // Stays NONE until the entity is added to a scene
+    EntityHandle getHandle() const {
+        return this->handle;
+    }
+
+    EntityHandle getParent() const {
+        return this->parent;
+    }
+
+    // Follows the parent, origin becomes the offset from it. Moved by Scene::update after the parent moved.
+    void attachTo(EntityHandle parent);
+
+    // Stays where the parent left it
+    void detach() {
+        this->parent = HandleTable::NONE;
+    }
+
+    unsigned int getCategory() const {
+        return this->category;
+    }
+
+    void setCategory(unsigned int category) {
+        this->category = category;
+    }
+
+    unsigned int getCollisionMask() const {
+        return this->collisionMask;
+    }
+
+    void setCollisionMask(unsigned int collisionMask) {
+        this->collisionMask = collisionMask;
+    }
+
+    unsigned int getBlockingMask() const {
+        return this->blockingMask;
+    }
+
+    void setBlockingMask(unsigned int blockingMask) {
+        this->blockingMask = blockingMask;
+    }
+
     const Math::Vec3& getOrigin() const {
         return this->origin;
     }
@@ -130,6 +208,7 @@ public:
 
     void setOrigin(const Math::Vec3& origin) {
         this->origin = origin;
+        this->parentVersion = 0;  // Attached ones follow their parent again with the new offset
         this->setPosition(this->getPosition());
     }
 
@@ -146,13 +225,25 @@ public:
     }
 
     void setSpeed(const Math::Vec3& speed) {
+        if (speed != this->currentSpeed) {
+            this->sleeping = false;
+        }
+
         this->currentSpeed = speed;
     }
 
     void accelerateBy(const Math::Vec3& acceleration) {
+        if (acceleration != Math::Vec3::ZERO) {
+            this->sleeping = false;
+        }
+
         this->currentSpeed += acceleration;
     }
 
+    bool isSleeping() const {
+        return this->sleeping;
+    }
+
     bool isVisible() const {
         return this->visible;
     }
@@ -185,22 +276,46 @@ public:
 
 protected:
     friend class Scene;
+    friend class BodyStorage;
 
     virtual void onCollision(const std::shared_ptr<Entity>& another, Collider::CollideSide side) = 0;
     virtual void animate(float frameTime) = 0;
 
+    // Also resets the collision layers to the type defaults
+    void setType(EntityType type) {
+        this->type = type;
+        this->category = 1 << type;
+        this->collisionMask = getDefaultCollisionMask(type);
+        this->blockingMask = getDefaultBlockingMask(type);
+    }
+
+    // Keeps scene broad phase in sync with the collider
+    void updateBounds();
+
     std::unique_ptr<Collider> collider;
     std::shared_ptr<Opengl::Primitive> primitive;
-    std::weak_ptr<class Scene> scene;
+    class Scene* scene;  // Owner, cleared on removal and by the scene destructor
+    EntityHandle handle;
+    EntityHandle parent;  // NONE unless attached
+    unsigned int transformVersion;  // Bumped by every move
+    unsigned int parentVersion;     // Of the parent when last followed, 0 if never
+    bool resolving;                 // Somewhere up the chain being resolved, breaks cycles
 
     Math::Vec3 currentSpeed;
     Math::Vec3 origin;
+    Math::Vec3 previousPosition;  // Primitive position before the last Scene::update
 
     EntityType type;
+    unsigned int category;
+    unsigned int collisionMask;
+    unsigned int blockingMask;
     bool visible;
     bool passive;
     bool collidable;
     bool destroyed;
+    bool stationary;  // Indexed as static scene geometry
+    int bodyId;       // Slot in scene BodyStorage, -1 if none
+    bool sleeping;    // At rest, not simulated until woken
 };
 
 }  // namespace Game
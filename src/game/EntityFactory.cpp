@@ -22,6 +22,7 @@
 
 #include "EntityFactory.h"
 #include "Logger.h"
+#include "PoolAllocator.h"
 
 #include <sstream>
 
@@ -37,7 +38,7 @@ std::shared_ptr<Pack> EntityFactory::createPack(const std::string& name) const {
         return nullptr;
     }
 
-    std::shared_ptr<Game::Pack> pack(new Game::Pack());
+    auto pack = std::allocate_shared<Game::Pack>(Utils::PoolAllocator<Game::Pack>());
     this->loadBase(pack, asset);
 
     json_object* payload = nullptr;
@@ -150,7 +151,7 @@ std::shared_ptr<Weapon> EntityFactory::createWeapon(const std::string& name) con
         return nullptr;
     }
 
-    std::shared_ptr<Game::Weapon> weapon(new Game::Weapon());
+    auto weapon = std::allocate_shared<Game::Weapon>(Utils::PoolAllocator<Game::Weapon>());
     this->loadBase(weapon, asset);
 
     json_object* slot = nullptr;
@@ -190,6 +191,13 @@ std::shared_ptr<Weapon> EntityFactory::createWeapon(const std::string& name) con
         weapon->setAmmo(json_object_get_int(ammo));
     }
 
+    json_object* damage = nullptr;
+    if (!json_object_object_get_ex(asset.get(), "damage", &damage) || json_object_get_type(damage) != json_type_int) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_WARNING, "Parameter `damage' is not set");
+    } else {
+        weapon->setDamage(json_object_get_int(damage));
+    }
+
     json_object* groupingAngle = nullptr;
     if (!json_object_object_get_ex(asset.get(), "grouping_angle", &groupingAngle) ||
             json_object_get_type(groupingAngle) != json_type_double) {
@@ -206,6 +214,9 @@ std::shared_ptr<Weapon> EntityFactory::createWeapon(const std::string& name) con
         weapon->setFiringSpeed(json_object_get_double(firingSpeed));
     }
 
+    // Have every trace this weapon may need before the shooting starts
+    this->getTracePool().reserve(weapon->getFiringSpeed());
+
     return weapon;
 }
 
@@ -225,15 +236,7 @@ std::shared_ptr<Game::Widget> EntityFactory::createWidget(const std::string& nam
 }
 
 std::shared_ptr<Game::ShotTrace> EntityFactory::createTrace(const Math::Vec3& from, const Math::Vec3& to) const {
-    Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Building ShotTrace from (%.3f; %.3f) to (%.3f; %.3f)",
-            from.get(Math::Vec3::X), from.get(Math::Vec3::Y), to.get(Math::Vec3::X), to.get(Math::Vec3::Y));
-
-    auto effect = this->resourceCache->loadEffect("shaders/trace.shader");
-
-    std::shared_ptr<Game::ShotTrace> trace(new Game::ShotTrace(from, to));
-    trace->getLine()->setEffect(effect);
-
-    return trace;
+    return this->getTracePool().acquire(from, to);
 }
 
 std::shared_ptr<Game::Label> EntityFactory::createLabel(const std::string& fontName, unsigned int size) const {
@@ -266,6 +269,14 @@ std::shared_ptr<SpriteEntity> EntityFactory::createBlock(const std::string& name
     return entity;
 }
 
+TracePool& EntityFactory::getTracePool() const {
+    if (this->tracePool->getEffect() == nullptr) {
+        this->tracePool->setEffect(this->resourceCache->loadEffect("shaders/trace.shader"));
+    }
+
+    return *this->tracePool;
+}
+
 void EntityFactory::loadBase(std::shared_ptr<Game::SpriteEntity> entity,
         const std::shared_ptr<json_object> asset) const {
     json_object* texture = nullptr;
@@ -274,6 +285,7 @@ void EntityFactory::loadBase(std::shared_ptr<Game::SpriteEntity> entity,
         Utils::Logger::getInstance().log(Utils::Logger::LOG_WARNING, "Parameter `texture' is not set");
     } else {
         entity->getSprite()->setTexture(this->resourceCache->loadTexture(json_object_get_string(texture)));
+        entity->getSprite()->setRegion(this->resourceCache->getRegion(json_object_get_string(texture)));
     }
 
     json_object* effect = nullptr;
@@ -301,6 +313,55 @@ void EntityFactory::loadBase(std::shared_ptr<Game::SpriteEntity> entity,
             json_object_get_type(collidable) == json_type_boolean) {
         entity->setCollidable(json_object_get_boolean(collidable));
     }
+
+    unsigned int category = entity->getCategory();
+    unsigned int collisionMask = entity->getCollisionMask();
+    unsigned int blockingMask = entity->getBlockingMask();
+
+    this->loadLayers(asset, "category", category);
+    this->loadLayers(asset, "collision_mask", collisionMask);
+    this->loadLayers(asset, "blocking_mask", blockingMask);
+
+    entity->setCategory(category);
+    entity->setCollisionMask(collisionMask);
+    entity->setBlockingMask(blockingMask);
+}
+
+void EntityFactory::loadLayers(const std::shared_ptr<json_object> asset, const char* key,
+        unsigned int& layers) const {
+    json_object* names = nullptr;
+    if (!json_object_object_get_ex(asset.get(), key, &names)) {
+        return;  // Keep type defaults
+    }
+
+    if (json_object_get_type(names) != json_type_array) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_WARNING, "Parameter `%s' is not an array", key);
+        return;
+    }
+
+    unsigned int newLayers = 0;
+    int length = json_object_array_length(names);  // size_t since json-c 0.13, int before
+    for (int i = 0; i < length; i++) {
+        json_object* name = json_object_array_get_idx(names, i);
+        std::string layer((json_object_get_type(name) == json_type_string) ? json_object_get_string(name) : "");
+
+        if (layer == "generic") {
+            newLayers |= Entity::CollisionLayer::LAYER_GENERIC;
+        } else if (layer == "player") {
+            newLayers |= Entity::CollisionLayer::LAYER_PLAYER;
+        } else if (layer == "weapon") {
+            newLayers |= Entity::CollisionLayer::LAYER_WEAPON;
+        } else if (layer == "pack") {
+            newLayers |= Entity::CollisionLayer::LAYER_PACK;
+        } else if (layer == "widget") {
+            newLayers |= Entity::CollisionLayer::LAYER_WIDGET;
+        } else {
+            Utils::Logger::getInstance().log(Utils::Logger::LOG_WARNING,
+                    "Got unknown `%s' layer `%s'", key, layer.c_str());
+        }
+    }
+
+    layers = newLayers;
 }
 
 }  // namespace Game
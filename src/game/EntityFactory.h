@@ -29,6 +29,7 @@
 #include "Widget.h"
 #include "Label.h"
 #include "ShotTrace.h"
+#include "TracePool.h"
 #include "SpriteEntity.h"
 #include "ResourceCache.h"
 #include "NonCopyable.h"
@@ -57,6 +58,11 @@ public:
         this->resourceCache = resourceCache;
     }
 
+    // Frees the recycled shot traces, call before the GL context goes away
+    void clearTraces() {
+        this->tracePool->clear();
+    }
+
     std::shared_ptr<Game::Pack> createPack(const std::string& name) const;
     std::shared_ptr<Game::Player> createPlayer(const std::string& name) const;
     std::shared_ptr<Game::Weapon> createWeapon(const std::string& name) const;
@@ -67,12 +73,17 @@ public:
 
 private:
     EntityFactory():
-            resourceCache(new Utils::ResourceCache()) {
+            resourceCache(new Utils::ResourceCache()),
+            tracePool(new TracePool()) {
     }
 
+    TracePool& getTracePool() const;
+
     void loadBase(std::shared_ptr<Game::SpriteEntity> entity, const std::shared_ptr<json_object> asset) const;
+    void loadLayers(const std::shared_ptr<json_object> asset, const char* key, unsigned int& layers) const;
 
     std::shared_ptr<Utils::ResourceCache> resourceCache;
+    std::unique_ptr<TracePool> tracePool;
 };
 
 }  // namespace Game
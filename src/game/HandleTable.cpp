@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "HandleTable.h"
+#include "Logger.h"
+
+namespace PolandBall {
+
+namespace Game {
+
+const EntityHandle HandleTable::NONE;
+
+EntityHandle HandleTable::insert(Entity* entity) {
+    unsigned int index = 0;
+
+    if (!this->freeIndexes.empty()) {
+        index = this->freeIndexes.back();
+        this->freeIndexes.pop_back();
+    } else {
+        index = this->entities.size();
+        if (index > INDEX_MASK) {
+            Utils::Logger::getInstance().log(Utils::Logger::LOG_ERROR, "Out of entity handles");
+            return NONE;
+        }
+
+        this->entities.push_back(nullptr);
+        this->generations.push_back(1);
+    }
+
+    this->entities[index] = entity;
+    return (this->generations[index] << INDEX_BITS) | index;
+}
+
+void HandleTable::remove(EntityHandle handle) {
+    if (this->get(handle) == nullptr) {
+        return;
+    }
+
+    // Bumping the generation invalidates every copy of the handle, 0 stays reserved
+    unsigned int index = handle & INDEX_MASK;
+    this->generations[index] = (this->generations[index] % GENERATION_MASK) + 1;
+    this->entities[index] = nullptr;
+    this->freeIndexes.push_back(index);
+}
+
+void HandleTable::clear() {
+    for (unsigned int index = 0; index < this->entities.size(); index++) {
+        if (this->entities[index] != nullptr) {
+            this->remove((this->generations[index] << INDEX_BITS) | index);
+        }
+    }
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
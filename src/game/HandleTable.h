@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HANDLETABLE_H
+#define HANDLETABLE_H
+
+#include "NonCopyable.h"
+
+#include <vector>
+
+namespace PolandBall {
+
+namespace Game {
+
+class Entity;
+
+// 32 bits: slot index below, slot generation above, 0 never refers to anything
+typedef unsigned int EntityHandle;
+
+// Generational slots resolving handles to live entities, stale handles resolve to nullptr
+class HandleTable: public Common::NonCopyable {
+public:
+    enum {
+        INDEX_BITS = 20,
+        INDEX_MASK = (1 << INDEX_BITS) - 1,
+        GENERATION_MASK = (1 << (32 - INDEX_BITS)) - 1
+    };
+
+    static const EntityHandle NONE = 0;
+
+    EntityHandle insert(Entity* entity);
+    void remove(EntityHandle handle);
+    void clear();
+
+    Entity* get(EntityHandle handle) const {
+        unsigned int index = handle & INDEX_MASK;
+        if (handle == NONE || index >= this->entities.size() ||
+                this->generations[index] != (handle >> INDEX_BITS)) {
+            return nullptr;
+        }
+
+        return this->entities[index];
+    }
+
+private:
+    std::vector<Entity*> entities;
+    std::vector<unsigned int> generations;
+    std::vector<unsigned int> freeIndexes;
+};
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // HANDLETABLE_H
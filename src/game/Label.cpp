@@ -34,8 +34,10 @@ Label::Label() {
     this->widthScaleFactor = 1.0f;
     this->heightScaleFactor = 1.0f;
 
-    GLint viewportParameters[4];
-    glGetIntegerv(GL_VIEWPORT, viewportParameters);
+    GLint viewportParameters[4] = { 0, 0, 1, 1 };
+    if (Opengl::Context::isAvailable()) {
+        glGetIntegerv(GL_VIEWPORT, viewportParameters);
+    }
 
     this->ndc.set(0, 0, 2.0f / (viewportParameters[2] / 1.0f));
     this->ndc.set(0, 3, -1.0f);
@@ -48,7 +48,7 @@ public:
         this->bounce = 0.0f;
 
         this->passive = false;
-        this->type = Entity::EntityType::TYPE_PACK;
+        this->setType(Entity::EntityType::TYPE_PACK);
     }
 
     PayloadType getPayloadType() const {
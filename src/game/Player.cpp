@@ -22,6 +22,7 @@
 
 #include "Player.h"
 #include "Pack.h"
+#include "Scene.h"
 
 #include <cfloat>
 
@@ -45,23 +46,41 @@ Player::Player():
     this->armor = 0;
 
     this->activeSlot = -1;
-    this->weaponHandle = -1;
+    this->weapons.fill(HandleTable::NONE);
     this->state = PlayerState::STATE_IDLE;
     this->previousState = this->state;
 
     this->passive = false;
-    this->type = Entity::EntityType::TYPE_PLAYER;
+    this->setType(Entity::EntityType::TYPE_PLAYER);
     this->sprite->shearX(0.0f, 2);
 }
 
-void Player::pickWeapon(const std::shared_ptr<Weapon>& weapon) {
+Weapon* Player::getWeapon(Weapon::WeaponSlot slot) const {
+    if (this->scene == nullptr) {
+        return nullptr;
+    }
+
+    // Handles of destroyed weapons resolve to nullptr, the slot is then empty
+    return static_cast<Weapon*>(this->scene->getEntity(this->weapons[slot]));
+}
+
+void Player::applyDamage(int damage) {
+    int absorbed = (damage < this->armor) ? damage : this->armor;
+    this->armor -= absorbed;
+    this->health = (this->health > damage - absorbed) ? this->health - (damage - absorbed) : 0;
+}
+
+void Player::pickWeapon(Weapon* weapon) {
     Weapon::WeaponSlot targetSlot = weapon->getTargetSlot();
 
     if (this->getWeapon(targetSlot) == nullptr) {
-        this->weapons[targetSlot] = weapon;
-        this->weapons[targetSlot]->setState(Weapon::WeaponState::STATE_PICKED);
+        this->weapons[targetSlot] = weapon->getHandle();
+        weapon->setOwner(this->getHandle());
+        weapon->attachTo(this->getHandle());
+        weapon->setState(Weapon::WeaponState::STATE_PICKED);
+        weapon->setHolstered(true);
 
-        auto weaponSprite = std::dynamic_pointer_cast<Opengl::Sprite>(this->weapons[targetSlot]->getPrimitive());
+        auto weaponSprite = std::dynamic_pointer_cast<Opengl::Sprite>(weapon->getPrimitive());
         weaponSprite->shearX(0.0f, 2);
 
         if (targetSlot > this->activeSlot || this->activeSlot == -1) {
@@ -71,21 +90,20 @@ void Player::pickWeapon(const std::shared_ptr<Weapon>& weapon) {
 }
 
 void Player::activateSlot(Weapon::WeaponSlot slot) {
-    if (this->weapons[slot] == nullptr) {
+    Weapon* weapon = this->getWeapon(slot);
+    if (weapon == nullptr) {
         return;
     }
 
-    this->weapons[slot]->aimAt(this->target);  // Sync with player
+    weapon->aimAt(this->target);  // Sync with player
     this->activeSlot = slot;
 
-    if (this->weaponHandle != -1) {
-        this->positionChanged.disconnect(this->weaponHandle);
+    for (int i = 0; i < static_cast<int>(this->weapons.size()); i++) {
+        Weapon* slotWeapon = this->getWeapon(static_cast<Weapon::WeaponSlot>(i));
+        if (slotWeapon != nullptr) {
+            slotWeapon->setHolstered(i != slot);
+        }
     }
-
-    this->weaponHandle = this->positionChanged.connect(
-            std::bind(static_cast<void(Weapon::*)(const Math::Vec3&)>(&Weapon::setPosition),
-            this->weapons[slot], std::placeholders::_1));
-    this->positionChanged(this->getPosition());
 }
 
 void Player::aimAt(const Math::Vec3& target) {
@@ -113,8 +131,10 @@ void Player::aimAt(const Math::Vec3& target) {
     this->roll(newAngle);
     this->sprite->shearX(shear, 2);
 
-    if (this->activeSlot != -1) {
-        this->weapons[this->activeSlot]->aimAt(newTarget);
+    Weapon* weapon = (this->activeSlot != -1) ?
+            this->getWeapon(static_cast<Weapon::WeaponSlot>(this->activeSlot)) : nullptr;
+    if (weapon != nullptr) {
+        weapon->aimAt(newTarget);
     }
 
     this->target = target;
@@ -122,7 +142,7 @@ void Player::aimAt(const Math::Vec3& target) {
 
 void Player::onCollision(const std::shared_ptr<Entity>& another, Collider::CollideSide side) {
     if (another->getType() == Entity::EntityType::TYPE_WEAPON) {
-        auto weapon = std::dynamic_pointer_cast<Weapon>(another);
+        auto weapon = static_cast<Weapon*>(another.get());
         if (weapon->getState() == Weapon::WeaponState::STATE_AVAILABLE) {
             this->pickWeapon(weapon);
             return;
@@ -130,7 +150,7 @@ void Player::onCollision(const std::shared_ptr<Entity>& another, Collider::Colli
     }
 
     if (another->getType() == Entity::EntityType::TYPE_PACK) {
-        auto pack = std::dynamic_pointer_cast<Pack>(another);
+        auto pack = static_cast<Pack*>(another.get());
         Weapon::WeaponSlot slot = Weapon::WeaponSlot::SLOT_MEELE;
         int value = pack->getValue();
         bool packStaysAlive = true;
@@ -155,12 +175,13 @@ void Player::onCollision(const std::shared_ptr<Entity>& another, Collider::Colli
                 break;
         }
 
-        if (slot != Weapon::WeaponSlot::SLOT_MEELE && this->weapons[slot] != nullptr) {
-            int maxAmmo = this->weapons[slot]->getMaxAmmo();
-            int ammo = this->weapons[slot]->getAmmo();
+        Weapon* weapon = this->getWeapon(slot);
+        if (slot != Weapon::WeaponSlot::SLOT_MEELE && weapon != nullptr) {
+            int maxAmmo = weapon->getMaxAmmo();
+            int ammo = weapon->getAmmo();
 
             packStaysAlive = (ammo == maxAmmo);
-            this->weapons[slot]->setAmmo((ammo + value > maxAmmo) ? maxAmmo : ammo + value);
+            weapon->setAmmo((ammo + value > maxAmmo) ? maxAmmo : ammo + value);
         }
 
         if (!packStaysAlive) {
@@ -248,20 +269,18 @@ void Player::dropWeapon() {
         return;
     }
 
-    auto weapon = this->weapons[this->activeSlot];
-    this->weapons[this->activeSlot] = nullptr;
+    Weapon* weapon = this->getWeapon(static_cast<Weapon::WeaponSlot>(this->activeSlot));
+    this->weapons[this->activeSlot] = HandleTable::NONE;
 
     for (this->activeSlot = this->weapons.size() - 1; this->activeSlot > -1; this->activeSlot--) {
-        if (this->weapons[this->activeSlot] != nullptr) {
+        if (this->getWeapon(static_cast<Weapon::WeaponSlot>(this->activeSlot)) != nullptr) {
             this->activateSlot(static_cast<Weapon::WeaponSlot>(this->activeSlot));  // TODO: Remove cast
             break;
         }
     }
 
-    if (this->activeSlot < 0) {
-        this->positionChanged.disconnect(this->weaponHandle);
-        this->weaponHandle = -1;
-        this->activeSlot = -1;
+    if (weapon == nullptr) {
+        return;
     }
 
     float targetSignCorrection = (this->target.get(Math::Vec3::X) < 0.0f) ? -1.0f : 1.0f;
@@ -269,6 +288,9 @@ void Player::dropWeapon() {
 
     weapon->aimAt(Math::Vec3::UNIT_X * targetSignCorrection);
     weapon->setState(Weapon::WeaponState::STATE_THROWN);
+    weapon->setOwner(HandleTable::NONE);
+    weapon->detach();
+    weapon->setHolstered(false);
     weapon->setPosition(weapon->getPosition() + Math::Vec3::UNIT_Y * 0.5f);  // Don't collide from bottom
 
     float hotizontalSpeed = this->getSpeed().get(Math::Vec3::X);
@@ -115,17 +115,21 @@ public:
         this->armor = armor;
     }
 
-    std::shared_ptr<Weapon>& getWeapon(Weapon::WeaponSlot slot) {
-        return this->weapons[slot];
-    }
+    // nullptr for an empty slot
+    Weapon* getWeapon(Weapon::WeaponSlot slot) const;
+
+    // Armor soaks up damage before health does
+    void applyDamage(int damage);
 
-    void pickWeapon(const std::shared_ptr<Weapon>& weapon);
+    void pickWeapon(Weapon* weapon);
     void activateSlot(Weapon::WeaponSlot slot);
 
     void aimAt(const Math::Vec3& target);
     void shoot() {
-        if (this->activeSlot != -1) {
-            this->weapons[this->activeSlot]->fire();
+        Weapon* weapon = (this->activeSlot != -1) ?
+                this->getWeapon(static_cast<Weapon::WeaponSlot>(this->activeSlot)) : nullptr;
+        if (weapon != nullptr) {
+            weapon->fire();
         }
     }
 
@@ -137,7 +141,7 @@ private:
 
     void dropWeapon();
 
-    std::array<std::shared_ptr<Weapon>, 3> weapons;
+    std::array<EntityHandle, 3> weapons;  // Resolved through the scene
     Math::Vec3 target;
 
     float maxMoveSpeed;
@@ -154,7 +158,6 @@ private:
     int armor;
 
     int activeSlot;
-    int weaponHandle;
     int state;
     int previousState;
 };
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RayGrid.h"
+
+namespace PolandBall {
+
+namespace Game {
+
+void RayGrid::clear() {
+    this->boxes.clear();
+    this->ids.clear();
+    this->cellItems.clear();
+    this->cellOffsets.clear();
+    this->columns = 0;
+    this->rows = 0;
+}
+
+void RayGrid::insert(int id, const Collider::Box& box) {
+    // Factors may be negative, store the box normalized
+    Collider::Box normalized = {
+        std::min(box.left, box.right), std::max(box.left, box.right),
+        std::min(box.bottom, box.top), std::max(box.bottom, box.top)
+    };
+
+    this->boxes.push_back(normalized);
+    this->ids.push_back(id);
+}
+
+void RayGrid::build() {
+    int size = this->getSize();
+    this->stamps.assign(size, 0);
+    this->stamp = 0;
+
+    if (size == 0) {
+        this->columns = 0;
+        this->rows = 0;
+        return;
+    }
+
+    Collider::Box bounds = this->boxes[0];
+    for (auto& box: this->boxes) {
+        bounds.left = std::min(bounds.left, box.left);
+        bounds.right = std::max(bounds.right, box.right);
+        bounds.bottom = std::min(bounds.bottom, box.bottom);
+        bounds.top = std::max(bounds.top, box.top);
+    }
+
+    // Coarser cells for huge worlds, the grid has to stay dense
+    float width = bounds.right - bounds.left;
+    float height = bounds.top - bounds.bottom;
+    this->cellSize = std::max(this->baseCellSize, std::max(width, height) / MAX_CELLS);
+    this->minX = bounds.left;
+    this->minY = bounds.bottom;
+    this->columns = static_cast<int>(width / this->cellSize) + 1;
+    this->rows = static_cast<int>(height / this->cellSize) + 1;
+
+    // Counting sort of items into cells: count, prefix sum, fill
+    int cells = this->columns * this->rows;
+    this->cellOffsets.assign(cells + 1, 0);
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int item = 0; item < size; item++) {
+            const Collider::Box& box = this->boxes[item];
+            int minCellX = std::min(static_cast<int>((box.left - this->minX) / this->cellSize), this->columns - 1);
+            int maxCellX = std::min(static_cast<int>((box.right - this->minX) / this->cellSize), this->columns - 1);
+            int minCellY = std::min(static_cast<int>((box.bottom - this->minY) / this->cellSize), this->rows - 1);
+            int maxCellY = std::min(static_cast<int>((box.top - this->minY) / this->cellSize), this->rows - 1);
+
+            for (int y = minCellY; y <= maxCellY; y++) {
+                for (int x = minCellX; x <= maxCellX; x++) {
+                    int cell = y * this->columns + x;
+                    if (pass == 0) {
+                        this->cellOffsets[cell + 1]++;
+                    } else {
+                        this->cellItems[this->cellCursors[cell]++] = item;
+                    }
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (int cell = 0; cell < cells; cell++) {
+                this->cellOffsets[cell + 1] += this->cellOffsets[cell];
+            }
+
+            this->cellItems.resize(this->cellOffsets[cells]);
+            this->cellCursors.assign(this->cellOffsets.begin(), this->cellOffsets.end() - 1);
+        }
+    }
+}
+
+bool RayGrid::intersect(const Collider::Box& box, float originX, float originY,
+        float directionX, float directionY, float maxDistance, float& distance) {
+    // Slab test, axis parallel rays only have to start between the slab planes
+    float near = 0.0f;
+    float far = maxDistance;
+
+    if (directionX != 0.0f) {
+        float first = (box.left - originX) / directionX;
+        float second = (box.right - originX) / directionX;
+        near = std::max(near, std::min(first, second));
+        far = std::min(far, std::max(first, second));
+    } else if (originX < box.left || originX > box.right) {
+        return false;
+    }
+
+    if (directionY != 0.0f) {
+        float first = (box.bottom - originY) / directionY;
+        float second = (box.top - originY) / directionY;
+        near = std::max(near, std::min(first, second));
+        far = std::min(far, std::max(first, second));
+    } else if (originY < box.bottom || originY > box.top) {
+        return false;
+    }
+
+    if (near > far) {
+        return false;
+    }
+
+    distance = near;
+    return true;
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
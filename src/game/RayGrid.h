@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RAYGRID_H
+#define RAYGRID_H
+
+#include "NonCopyable.h"
+#include "Collider.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace PolandBall {
+
+namespace Game {
+
+// Dense uniform grid over collider boxes, bulk built and walked cell by cell (DDA) along rays
+class RayGrid: public Common::NonCopyable {
+public:
+    RayGrid():
+            RayGrid(2.0f) {
+    }
+
+    RayGrid(float cellSize) {
+        this->baseCellSize = cellSize;
+        this->cellSize = cellSize;
+        this->minX = 0.0f;
+        this->minY = 0.0f;
+        this->columns = 0;
+        this->rows = 0;
+        this->stamp = 0;
+    }
+
+    int getSize() const {
+        return this->ids.size();
+    }
+
+    void clear();
+    void insert(int id, const Collider::Box& box);
+    void build();
+
+    // Nearest item accepted by filter(id) within maxDistance, direction has to be normalized
+    template <typename Filter>
+    bool raycast(float originX, float originY, float directionX, float directionY, float maxDistance,
+            Filter filter, int& hitId, float& hitDistance);
+
+private:
+    enum {
+        MAX_CELLS = 256  // Per axis, cells grow instead
+    };
+
+    static bool intersect(const Collider::Box& box, float originX, float originY,
+            float directionX, float directionY, float maxDistance, float& distance);
+
+    static bool contains(const Collider::Box& box, float x, float y) {
+        return x > box.left && x < box.right && y > box.bottom && y < box.top;
+    }
+
+    std::vector<Collider::Box> boxes;
+    std::vector<int> ids;
+    std::vector<unsigned int> stamps;  // Last ray each item was tested against
+    std::vector<int> cellOffsets;      // Items of every cell, ranged into cellItems
+    std::vector<int> cellItems;
+    std::vector<int> cellCursors;
+
+    float baseCellSize;
+    float cellSize;
+    float minX;
+    float minY;
+    int columns;
+    int rows;
+    unsigned int stamp;
+};
+
+template <typename Filter>
+bool RayGrid::raycast(float originX, float originY, float directionX, float directionY, float maxDistance,
+        Filter filter, int& hitId, float& hitDistance) {
+    if (this->ids.empty()) {
+        return false;
+    }
+
+    // Clip the ray to the grid first
+    Collider::Box bounds = {
+        this->minX, this->minX + this->columns * this->cellSize,
+        this->minY, this->minY + this->rows * this->cellSize
+    };
+
+    float distance = 0.0f;
+    if (!intersect(bounds, originX, originY, directionX, directionY, maxDistance, distance)) {
+        return false;
+    }
+
+    if (++this->stamp == 0) {
+        std::fill(this->stamps.begin(), this->stamps.end(), 0);
+        this->stamp = 1;
+    }
+
+    float startX = originX + directionX * distance;
+    float startY = originY + directionY * distance;
+    int cellX = std::min(std::max(static_cast<int>((startX - this->minX) / this->cellSize), 0), this->columns - 1);
+    int cellY = std::min(std::max(static_cast<int>((startY - this->minY) / this->cellSize), 0), this->rows - 1);
+
+    int stepX = (directionX > 0.0f) ? 1 : ((directionX < 0.0f) ? -1 : 0);
+    int stepY = (directionY > 0.0f) ? 1 : ((directionY < 0.0f) ? -1 : 0);
+
+    // Ray distances to the next cell border along each axis, and between two borders
+    float nextX = FLT_MAX;
+    float deltaX = FLT_MAX;
+    if (stepX != 0) {
+        float borderX = this->minX + (cellX + ((stepX > 0) ? 1 : 0)) * this->cellSize;
+        nextX = (borderX - originX) / directionX;
+        deltaX = this->cellSize / fabsf(directionX);
+    }
+
+    float nextY = FLT_MAX;
+    float deltaY = FLT_MAX;
+    if (stepY != 0) {
+        float borderY = this->minY + (cellY + ((stepY > 0) ? 1 : 0)) * this->cellSize;
+        nextY = (borderY - originY) / directionY;
+        deltaY = this->cellSize / fabsf(directionY);
+    }
+
+    hitId = -1;
+    hitDistance = maxDistance;
+
+    while (cellX >= 0 && cellX < this->columns && cellY >= 0 && cellY < this->rows) {
+        int cell = cellY * this->columns + cellX;
+
+        for (int i = this->cellOffsets[cell]; i < this->cellOffsets[cell + 1]; i++) {
+            int item = this->cellItems[i];
+            if (this->stamps[item] == this->stamp) {
+                continue;
+            }
+
+            this->stamps[item] = this->stamp;
+
+            // Rays leave the boxes they start in, these would be hit at distance 0
+            if (contains(this->boxes[item], originX, originY)) {
+                continue;
+            }
+
+            float itemDistance = 0.0f;
+            if (intersect(this->boxes[item], originX, originY, directionX, directionY, hitDistance, itemDistance) &&
+                    (hitId == -1 || itemDistance < hitDistance) && filter(this->ids[item])) {
+                hitId = this->ids[item];
+                hitDistance = itemDistance;
+            }
+        }
+
+        // Whatever lies in further cells is farther than this hit
+        float cellExit = std::min(nextX, nextY);
+        if ((hitId != -1 && hitDistance <= cellExit) || cellExit > maxDistance) {
+            break;
+        }
+
+        if (nextX < nextY) {
+            cellX += stepX;
+            nextX += deltaX;
+        } else {
+            cellY += stepY;
+            nextY += deltaY;
+        }
+    }
+
+    return (hitId != -1);
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // RAYGRID_H
@@ -24,17 +24,69 @@
 #include "Weapon.h"
 #include "Player.h"
 #include "Logger.h"
+#include "Profiler.h"
 
 #include <GL/glew.h>
+#include <cmath>
+#include <cstring>
 
 namespace PolandBall {
 
 namespace Game {
 
+Scene::~Scene() {
+    // Entities may outlive the scene, do not leave them pointing to it
+    for (auto& entity: this->bodies.entities) {
+        entity->scene = nullptr;
+        entity->handle = HandleTable::NONE;
+    }
+}
+
 void Scene::addEntity(const std::shared_ptr<Entity>& entity) {
     if (entity != nullptr) {
-        this->entities.insert(std::make_pair(entity->getType(), entity));
-        entity->scene = this->shared_from_this();
+        // Type tags match the classes, no need for RTTI
+        switch (entity->getType()) {
+            case Entity::EntityType::TYPE_PLAYER:
+                this->players.push_back(std::static_pointer_cast<Player>(entity));
+                break;
+
+            case Entity::EntityType::TYPE_WEAPON:
+                this->weapons.push_back(std::static_pointer_cast<Weapon>(entity));
+                break;
+
+            case Entity::EntityType::TYPE_PACK:
+                this->packs.push_back(std::static_pointer_cast<Pack>(entity));
+                break;
+
+            case Entity::EntityType::TYPE_WIDGET:
+                this->widgets.push_back(std::static_pointer_cast<Widget>(entity));
+                break;
+
+            default:
+                this->generics.push_back(entity);
+                break;
+        }
+
+        entity->scene = this;
+        entity->handle = this->handles.insert(entity.get());
+        if (entity->parent != HandleTable::NONE) {
+            this->attach(entity.get());
+        }
+
+        entity->previousPosition = entity->getPosition();
+        this->bodies.insert(entity);
+
+        if (entity->isCollidable()) {
+            this->rayGridDirty = true;
+
+            if (entity->isPassive()) {
+                // Blocks never move, keep them out of the dynamic broad phase
+                this->staticIndex.insert(entity);
+                entity->stationary = true;
+            } else {
+                this->spatialHash.insert(entity);
+            }
+        }
 
         auto effect = entity->getPrimitive()->getEffect();
         if (effect != nullptr) {
@@ -50,126 +102,887 @@ void Scene::addEntity(const std::shared_ptr<Entity>& entity) {
     }
 }
 
-void Scene::render() {
+void Scene::addOverlay(const std::shared_ptr<Widget>& widget) {
+    if (widget == nullptr) {
+        return;
+    }
+
+    this->overlay.push_back(widget);
+
+    auto effect = widget->getPrimitive()->getEffect();
+    if (effect != nullptr) {
+        this->overlayEffects.insert(effect);
+    }
+
+    auto label = std::dynamic_pointer_cast<Label>(widget);
+    if (label != nullptr) {
+        label->setProjection(this->overlayProjection);
+    }
+}
+
+void Scene::setViewport(int width, int height) {
+    this->overlayProjection = Math::Mat4();
+    this->overlayProjection.set(0, 0, 2.0f / width);
+    this->overlayProjection.set(0, 3, -1.0f);
+    this->overlayProjection.set(1, 1, 2.0f / height);
+    this->overlayProjection.set(1, 3, -1.0f);
+
+    for (auto& widget: this->overlay) {
+        auto label = std::dynamic_pointer_cast<Label>(widget);
+        if (label != nullptr) {
+            label->setProjection(this->overlayProjection);
+        }
+    }
+}
+
+void Scene::setBatchEffect(const std::shared_ptr<Opengl::RenderEffect>& spriteEffect,
+        const std::shared_ptr<Opengl::RenderEffect>& batchEffect) {
+    if (spriteEffect == nullptr || batchEffect == nullptr) {
+        return;
+    }
+
+    this->batchedEffect = spriteEffect;
+    this->batch.setEffect(batchEffect);
+    this->effects.insert(batchEffect);
+    this->overlayEffects.insert(batchEffect);
+}
+
+void Scene::render(float alpha) {
+    PROFILE_ZONE("Scene::render");
+
     glClear(GL_COLOR_BUFFER_BIT);
+    this->drawCalls = 0;
+
+    Math::Mat4 translation(this->camera.getTranslation());
+    if (alpha < 1.0f) {
+        Math::Vec3 position(this->previousCameraPosition +
+                (this->camera.getPosition() - this->previousCameraPosition) * alpha);
+        translation.set(0, 3, -position.get(Math::Vec3::X));
+        translation.set(1, 3, -position.get(Math::Vec3::Y));
+        translation.set(2, 3, -position.get(Math::Vec3::Z));
+    }
 
     Math::Mat4 mvp(this->camera.getProjection() *
                    this->camera.getRotation() *
-                   this->camera.getTranslation());
+                   translation);
 
     for (auto& effect: this->effects) {
         effect->setUniform("mvp", mvp);
     }
 
-    auto playerEntity = this->entities.find(Entity::EntityType::TYPE_PLAYER);
-    for (auto& entity: this->entities) {
-        if (!entity.second->isVisible()) {
-            continue;
-        }
+    // Buckets still draw in order, only sprites within one get grouped by texture
+    for (auto& entity: this->generics) {
+        this->renderEntity(entity.get(), alpha);
+    }
+    this->flushBatch(alpha);
 
+    for (auto& player: this->players) {
+        this->renderEntity(player.get(), alpha);
+    }
+    this->flushBatch(alpha);
+
+    for (auto& weapon: this->weapons) {
         /* Do not render any picked and non-active weapon */
-        if (entity.first == Entity::EntityType::TYPE_WEAPON) {
-            auto weapon = std::dynamic_pointer_cast<Weapon>(entity.second);
-            if (weapon->getState() == Weapon::WeaponState::STATE_PICKED) {
-                auto player = std::dynamic_pointer_cast<Player>(playerEntity->second);
-                bool skipWeapon = false;
-
-                for (int slot = 0; slot < 3; slot++) {
-                    auto& ownWeapon = player->getWeapon(static_cast<Game::Weapon::WeaponSlot>(slot));
-                    if (weapon == ownWeapon && slot != player->activeSlot) {
-                        skipWeapon = true;
-                        break;
-                    }
+        if (!weapon->isHolstered()) {
+            this->renderEntity(weapon.get(), alpha);
+        }
+    }
+    this->flushBatch(alpha);
+
+    for (auto& pack: this->packs) {
+        this->renderEntity(pack.get(), alpha);
+    }
+    this->flushBatch(alpha);
+
+    for (auto& widget: this->widgets) {
+        this->renderEntity(widget.get(), alpha);
+    }
+    this->flushBatch(alpha);
+
+    // Overlay effects may be shared with the world, they get the world projection back next frame
+    for (auto& effect: this->overlayEffects) {
+        effect->setUniform("mvp", this->overlayProjection);
+    }
+
+    for (auto& widget: this->overlay) {
+        this->renderEntity(widget.get(), 1.0f);
+    }
+    this->flushBatch(1.0f);
+}
+
+void Scene::attach(Entity* entity) {
+    if (entity->handle == HandleTable::NONE ||
+            std::find(this->attached.begin(), this->attached.end(), entity->handle) != this->attached.end()) {
+        return;
+    }
+
+    this->attached.push_back(entity->handle);
+}
+
+void Scene::updateTransforms() {
+    PROFILE_ZONE("Scene::updateTransforms");
+
+    // Children resolve their parents before themselves in any order, only those whose parent moved get moved
+    int last = 0;
+    for (auto handle: this->attached) {
+        Entity* entity = this->handles.get(handle);
+        if (entity == nullptr || entity->parent == HandleTable::NONE) {
+            continue;  // Destroyed or detached
+        }
+
+        this->resolveTransform(entity);
+        this->attached[last++] = handle;
+    }
+
+    this->attached.resize(last);
+
+    Entity* target = this->handles.get(this->cameraTarget);
+    if (target != nullptr) {
+        this->camera.setPosition(target->getPosition() - target->getOrigin());
+    }
+}
+
+void Scene::resolveTransform(Entity* entity) {
+    if (entity->parent == HandleTable::NONE || entity->resolving) {
+        return;  // Not attached or a cycle
+    }
+
+    Entity* parent = this->handles.get(entity->parent);
+    if (parent == nullptr) {
+        entity->parent = HandleTable::NONE;  // Orphans stay where they are
+        return;
+    }
+
+    entity->resolving = true;
+    this->resolveTransform(parent);
+
+    if (entity->parentVersion != parent->transformVersion) {
+        entity->setPosition(parent->getPosition() - parent->getOrigin());
+        entity->parentVersion = parent->transformVersion;
+    }
+
+    entity->resolving = false;
+}
+
+void Scene::renderEntity(Entity* entity, float alpha) {
+    if (!entity->isVisible()) {
+        return;
+    }
+
+    auto& primitive = entity->getPrimitive();
+    Opengl::Sprite* sprite = nullptr;
+    if (this->batchedEffect != nullptr && primitive->getEffect() == this->batchedEffect) {
+        sprite = dynamic_cast<Opengl::Sprite*>(primitive.get());
+    }
+
+    if (sprite == nullptr || sprite->getTexture() == nullptr) {
+        this->unbatched.push_back(entity);
+        return;
+    }
+
+    if (alpha < 1.0f) {
+        // Only the primitive is moved, colliders and signals stay at the latest state
+        Math::Vec3 position(primitive->getPosition());
+        primitive->setPosition(entity->previousPosition + (position - entity->previousPosition) * alpha);
+        this->batch.add(sprite);
+        primitive->setPosition(position);
+    } else {
+        this->batch.add(sprite);
+    }
+}
+
+void Scene::flushBatch(float alpha) {
+    this->drawCalls += this->batch.flush();
+
+    for (Entity* entity: this->unbatched) {
+        auto& primitive = entity->getPrimitive();
+        if (alpha < 1.0f) {
+            Math::Vec3 position(primitive->getPosition());
+            primitive->setPosition(entity->previousPosition + (position - entity->previousPosition) * alpha);
+            primitive->render();
+            primitive->setPosition(position);
+        } else {
+            primitive->render();
+        }
+
+        if (primitive->getEffect() != nullptr) {
+            this->drawCalls++;
+        }
+    }
+
+    this->unbatched.clear();
+}
+
+void Scene::update(float frameTime, float frameStep) {
+    PROFILE_ZONE("Scene::update");
+
+    this->previousCameraPosition = this->camera.getPosition();
+    for (auto& entity: this->bodies.entities) {
+        entity->previousPosition = entity->getPosition();
+    }
+
+    {
+        PROFILE_ZONE("Scene::gather");
+        this->staticIndex.build();
+        this->bodies.gather();
+    }
+
+    if (this->solverType == SolverType::TYPE_CONTINUOUS) {
+        PROFILE_ZONE("Scene::advance");
+        for (int id = 0; id < this->bodies.getSize(); id++) {
+            if (this->bodies.flags[id] & BodyStorage::FLAG_DYNAMIC) {
+                this->advance(this->bodies.entities[id], frameTime);
+            }
+        }
+    } else {
+        this->buildIslands(frameTime);
+
+        // With workers, islands step in parallel and callbacks wait for all of them to finish
+        bool deferred = (this->threadPool->getThreads() > 1);
+        this->threadPool->run(this->islandOffsets.size() - 1,
+                [this, frameTime, frameStep, deferred](int island, int thread) {
+            PROFILE_ZONE("Scene::simulate");
+            for (int i = this->islandOffsets[island]; i < this->islandOffsets[island + 1]; i++) {
+                this->simulate(this->islandBodies[i], frameTime, frameStep, this->workspaces[thread], deferred);
+            }
+        });
+
+        if (deferred) {
+            for (int id = 0; id < this->bodies.getSize(); id++) {
+                if (this->bodies.flags[id] & BodyStorage::FLAG_DYNAMIC) {
+                    this->bodies.scatter(id);
                 }
+            }
 
-                if (skipWeapon) {
-                    continue;
+            this->applyContacts();
+        }
+    }
+
+    this->updateSleep();
+
+    for (int id = 0; id < this->bodies.getSize() && !this->rayGridDirty; id++) {
+        const Entity* entity = this->bodies.entities[id].get();
+        if ((this->bodies.flags[id] & BodyStorage::FLAG_COLLIDABLE) &&
+                entity->getPosition() != entity->previousPosition) {
+            this->rayGridDirty = true;
+        }
+    }
+
+    // Once per update however many times parents moved during the steps
+    this->updateTransforms();
+
+    PROFILE_ZONE("Scene::animate");
+    this->updateEntities(this->generics, frameTime);
+    this->updateEntities(this->players, frameTime);
+    this->updateEntities(this->weapons, frameTime);
+    this->updateEntities(this->packs, frameTime);
+    this->updateEntities(this->widgets, frameTime);
+}
+
+void Scene::removeEntity(Entity* entity) {
+    Utils::Logger::getInstance().log(Utils::Logger::LOG_DEBUG, "Entity %p destroyed", entity);
+    entity->scene = nullptr;
+    this->handles.remove(entity->handle);
+    entity->handle = HandleTable::NONE;
+    this->spatialHash.remove(entity);
+    this->staticIndex.remove(entity);
+    this->bodies.remove(entity);
+    this->rayGridDirty = true;  // Body ids got shuffled
+}
+
+unsigned long long Scene::getStateHash() const {
+    // FNV-1a over the raw bits, the same floats must come out of the same simulation
+    unsigned long long hash = 14695981039346656037ULL;
+    auto mix = [&hash](unsigned int word) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (word >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+    };
+    auto mixFloat = [&mix](float value) {
+        unsigned int word = 0;
+        memcpy(&word, &value, sizeof(word));
+        mix(word);
+    };
+    auto mixEntity = [&mix, &mixFloat](const Entity* entity) {
+        Math::Vec3 position = entity->getPosition();
+        mix(entity->getType());
+        mixFloat(position.get(Math::Vec3::X));
+        mixFloat(position.get(Math::Vec3::Y));
+        mixFloat(entity->getSpeed().get(Math::Vec3::X));
+        mixFloat(entity->getSpeed().get(Math::Vec3::Y));
+    };
+
+    for (auto& entity: this->generics) {
+        mixEntity(entity.get());
+    }
+
+    for (auto& player: this->players) {
+        mixEntity(player.get());
+        mix(player->getHealth());
+        mix(player->getArmor());
+    }
+
+    for (auto& weapon: this->weapons) {
+        mixEntity(weapon.get());
+        mix(weapon->getAmmo());
+        mix(weapon->getState());
+    }
+
+    for (auto& pack: this->packs) {
+        mixEntity(pack.get());
+    }
+
+    return hash;
+}
+
+bool Scene::raycast(const Math::Vec3& from, const Math::Vec3& direction, float maxDistance, unsigned int mask,
+        RayHit& hit, const Entity* except) {
+    hit.entity = nullptr;
+    hit.distance = maxDistance;
+    hit.point = from + direction * maxDistance;
+
+    if (this->rayGridDirty) {
+        this->rayGrid.clear();
+        for (int id = 0; id < this->bodies.getSize(); id++) {
+            if (this->bodies.flags[id] & BodyStorage::FLAG_COLLIDABLE) {
+                this->bodies.gatherBounds(id);
+                this->rayGrid.insert(id, this->bodies.getBox(id));
+            }
+        }
+
+        this->rayGrid.build();
+        this->rayGridDirty = false;
+    }
+
+    int id = -1;
+    float distance = maxDistance;
+    bool found = this->rayGrid.raycast(from.get(Math::Vec3::X), from.get(Math::Vec3::Y),
+            direction.get(Math::Vec3::X), direction.get(Math::Vec3::Y), maxDistance,
+            [this, mask, except](int body) {
+                const Entity* entity = this->bodies.entities[body].get();
+                return (this->bodies.categories[body] & mask) && entity != except && !entity->destroyed;
+            }, id, distance);
+
+    if (found) {
+        hit.entity = this->bodies.entities[id].get();
+        hit.distance = distance;
+        hit.point = from + direction * distance;
+    }
+
+    return found;
+}
+
+void Scene::updateSleep() {
+    this->awakeBodies = 0;
+    this->sleepingBodies = 0;
+
+    for (int id = 0; id < this->bodies.getSize(); id++) {
+        unsigned char flags = this->bodies.flags[id];
+
+        if (flags & BodyStorage::FLAG_DYNAMIC) {
+            // Continuous solver moves entities directly, read the speed from there
+            const Math::Vec3& speed = this->bodies.entities[id]->getSpeed();
+            bool slow = fabsf(speed.get(Math::Vec3::X)) < this->sleepSpeed &&
+                        fabsf(speed.get(Math::Vec3::Y)) < this->sleepSpeed;
+
+            int& restFrames = this->bodies.restFrames[id];
+            restFrames = ((flags & BodyStorage::FLAG_RESTING) && slow) ? restFrames + 1 : 0;
+
+            if (restFrames >= SLEEP_FRAMES) {
+                this->bodies.sleep(id);
+                this->sleepingBodies++;
+            } else {
+                this->awakeBodies++;
+            }
+        } else if (flags & BodyStorage::FLAG_SLEEPING) {
+            this->sleepingBodies++;
+        }
+    }
+}
+
+void Scene::updateBounds(Entity* entity) {
+    if (entity->stationary) {
+        Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO,
+                "Entity %p moved, no longer treated as static geometry", entity);
+
+        this->spatialHash.insert(this->staticIndex.remove(entity));
+        entity->stationary = false;
+    } else {
+        this->spatialHash.update(entity);
+    }
+
+    if (entity->bodyId != -1) {
+        int id = entity->bodyId;
+        Collider::Box box = this->bodies.getBox(id);
+        this->bodies.gatherBounds(id);
+
+        // Moved outside of the simulation, which keeps bounds current itself
+        Collider::Box moved = this->bodies.getBox(id);
+        if ((this->bodies.flags[id] & BodyStorage::FLAG_COLLIDABLE) &&
+                (box.left != moved.left || box.right != moved.right ||
+                 box.bottom != moved.bottom || box.top != moved.top)) {
+            this->rayGridDirty = true;
+        }
+    }
+}
+
+void Scene::simulate(int id, float frameTime, float frameStep, Workspace& workspace, bool deferred) {
+    this->packNeighbours(id, workspace);
+
+    int firstNeighbour = this->neighbourOffsets[id];
+    int count = this->neighbourOffsets[id + 1] - firstNeighbour;
+    bool resting = false;
+
+    float positionX = this->bodies.positionX[id];
+    float positionY = this->bodies.positionY[id];
+    float positionZ = this->bodies.positionZ[id];
+    float speedX = this->bodies.speedX[id];
+    float speedY = this->bodies.speedY[id];
+    float speedZ = this->bodies.speedZ[id];
+
+    float gravityX = this->gravityAcceleration.get(Math::Vec3::X);
+    float gravityY = this->gravityAcceleration.get(Math::Vec3::Y);
+    float gravityZ = this->gravityAcceleration.get(Math::Vec3::Z);
+
+    for (float step = frameStep, totalTime = step; totalTime < frameTime; totalTime += step) {
+        speedX += gravityX * step;
+        speedY += gravityY * step;
+        speedZ += gravityZ * step;
+
+        Collider::Box box = {
+            positionX - this->bodies.halfWidth[id], positionX + this->bodies.halfWidth[id],
+            positionY - this->bodies.halfHeight[id], positionY + this->bodies.halfHeight[id]
+        };
+
+        Collider::classify(box, workspace.left.data(), workspace.right.data(),
+                workspace.bottom.data(), workspace.top.data(), count, workspace.sides.data());
+
+        for (int i = 0; i < count; i++) {
+            // Not touching means neither a callback nor a response
+            Collider::CollideSide side = workspace.sides[i];
+            int another = this->neighbourIds[firstNeighbour + i];
+
+            // Flags may change in callbacks, a picked weapon stops being collidable for instance
+            if (side == Collider::CollideSide::SIDE_NONE || !this->canCollide(id, another)) {
+                continue;
+            }
+
+            if (deferred) {
+                // Callbacks and wake ups may touch other islands, run them once the step is over.
+                // One per substep like the serial path, with the speed the serial callback would see.
+                workspace.contacts.push_back({ id, another, side, Math::Vec3(speedX, speedY, speedZ) });
+            } else {
+                this->bodies.wake(another);
+
+                // Callbacks work on entities, sync both of them around the call
+                this->bodies.positionX[id] = positionX;
+                this->bodies.positionY[id] = positionY;
+                this->bodies.positionZ[id] = positionZ;
+                this->bodies.speedX[id] = speedX;
+                this->bodies.speedY[id] = speedY;
+                this->bodies.speedZ[id] = speedZ;
+                this->bodies.scatter(id);
+
+                {
+                    PROFILE_ZONE("Entity::onCollision");
+                    std::shared_ptr<Entity> entity(this->bodies.entities[id]);
+                    entity->onCollision(this->bodies.entities[another], side);
                 }
+
+                this->bodies.gather(id);
+                this->bodies.gather(another);
+
+                positionX = this->bodies.positionX[id];
+                positionY = this->bodies.positionY[id];
+                positionZ = this->bodies.positionZ[id];
+                speedX = this->bodies.speedX[id];
+                speedY = this->bodies.speedY[id];
+                speedZ = this->bodies.speedZ[id];
+
+                // Either box may have moved, redo the lanes still to come
+                this->packNeighbours(id, workspace);
+                Collider::classify(this->bodies.getBox(id), workspace.left.data(), workspace.right.data(),
+                        workspace.bottom.data(), workspace.top.data(), count, workspace.sides.data());
+            }
+
+            if (!this->canBlock(id, another)) {
+                continue;
+            }
+
+            resting = resting || (side == Collider::CollideSide::SIDE_BOTTOM);
+
+            if (side == Collider::CollideSide::SIDE_BOTTOM && speedY < 0.0f) {
+                speedY = 0.0f;
+            } else if (side == Collider::CollideSide::SIDE_TOP && speedY > 0.0f) {
+                speedY = 0.0f;
+            } else if (side == Collider::CollideSide::SIDE_LEFT && speedX < 0.0f) {
+                speedX = 0.0f;
+            } else if (side == Collider::CollideSide::SIDE_RIGHT && speedX > 0.0f) {
+                speedX = 0.0f;
             }
         }
 
-        entity.second->getPrimitive()->render();
+        positionX += speedX * step;
+        positionY += speedY * step;
+        positionZ += speedZ * step;
+        step = (frameTime - totalTime > frameStep) ? frameStep : frameTime - totalTime;
+    }
+
+    this->bodies.positionX[id] = positionX;
+    this->bodies.positionY[id] = positionY;
+    this->bodies.positionZ[id] = positionZ;
+    this->bodies.speedX[id] = speedX;
+    this->bodies.speedY[id] = speedY;
+    this->bodies.speedZ[id] = speedZ;
+
+    if (resting) {
+        this->bodies.flags[id] |= BodyStorage::FLAG_RESTING;
+    }
+
+    if (!deferred) {
+        this->bodies.scatter(id);
     }
 }
 
-void Scene::update(float frameTime, float frameStep) {
-    for (auto entity = this->entities.begin(); entity != this->entities.end(); ++entity) {
-        if (entity->second->destroyed || !entity->second->isCollidable() ||
-                (entity->second->isCollidable() && entity->second->isPassive())) {
+void Scene::buildIslands(float frameTime) {
+    PROFILE_ZONE("Scene::buildIslands");
+
+    int size = this->bodies.getSize();
+
+    // Farthest each dynamic body may get this frame, speed changes linearly under gravity
+    Collider::Box motionBounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+    this->reaches.resize(size);
+
+    for (int id = 0; id < size; id++) {
+        Collider::Box& reach = this->reaches[id];
+        reach = this->bodies.getBox(id);
+
+        if (!(this->bodies.flags[id] & BodyStorage::FLAG_DYNAMIC)) {
             continue;
         }
 
-        Entity::EntityType type = entity->second->getType();
-        if (type == Entity::EntityType::TYPE_WEAPON) {
-            auto weapon = std::dynamic_pointer_cast<Weapon>(entity->second);
-            if (weapon->getState() == Weapon::WeaponState::STATE_PICKED) {
-                continue;
+        float speedX = this->bodies.speedX[id];
+        float speedY = this->bodies.speedY[id];
+        float finalSpeedX = speedX + this->gravityAcceleration.get(Math::Vec3::X) * frameTime;
+        float finalSpeedY = speedY + this->gravityAcceleration.get(Math::Vec3::Y) * frameTime;
+        float motionX = std::max(fabsf(speedX), fabsf(finalSpeedX)) * frameTime;
+        float motionY = std::max(fabsf(speedY), fabsf(finalSpeedY)) * frameTime;
+        float extentX = fabsf(this->bodies.halfWidth[id]);
+        float extentY = fabsf(this->bodies.halfHeight[id]);
+
+        reach.left = this->bodies.positionX[id] - extentX - motionX;
+        reach.right = this->bodies.positionX[id] + extentX + motionX;
+        reach.bottom = this->bodies.positionY[id] - extentY - motionY;
+        reach.top = this->bodies.positionY[id] + extentY + motionY;
+
+        motionBounds.right = std::max(motionBounds.right, motionX);
+        motionBounds.top = std::max(motionBounds.top, motionY);
+    }
+
+    // Bodies whose reaches overlap may touch, those are neighbours and share an island
+    this->neighbourIds.clear();
+    this->neighbourOffsets.assign(size + 1, 0);
+    this->islandParents.resize(size);
+
+    for (int id = 0; id < size; id++) {
+        this->islandParents[id] = id;
+    }
+
+    for (int id = 0; id < size; id++) {
+        this->neighbourOffsets[id] = this->neighbourIds.size();
+
+        if (!(this->bodies.flags[id] & BodyStorage::FLAG_DYNAMIC)) {
+            continue;
+        }
+
+        const Collider::Box& reach = this->reaches[id];
+        this->candidates.clear();
+
+        if (this->broadPhaseType == BroadPhaseType::TYPE_SPATIAL_HASH) {
+            // Dynamic bodies are hashed where they start, widen by the most any of them moves
+            Math::Vec3 lowerBound(reach.left, reach.bottom, 0.0f);
+            Math::Vec3 upperBound(reach.right, reach.top, 0.0f);
+            Math::Vec3 motion(motionBounds.right, motionBounds.top, 0.0f);
+
+            this->staticIndex.query(lowerBound, upperBound, this->candidates);
+            this->spatialHash.query(lowerBound - motion, upperBound + motion,
+                    this->bodies.entities[id].get(), this->candidates);
+        } else {
+            for (auto& another: this->bodies.entities) {
+                this->candidates.push_back(another);
             }
         }
 
-        for (float step = frameStep, totalTime = step; totalTime < frameTime; totalTime += step) {
-            entity->second->setSpeed(entity->second->getSpeed() + this->gravityAcceleration * step);
+        for (auto& candidate: this->candidates) {
+            // Filtered out pairs never reach the narrow phase nor join islands
+            int another = candidate->bodyId;
+            if (another == id || !this->canCollide(id, another)) {
+                continue;
+            }
 
-            for (auto another = this->entities.begin(); another != this->entities.end(); ++another) {
-                if (another->second->destroyed || !another->second->isCollidable()) {
+            if (this->bodies.flags[another] & BodyStorage::FLAG_DYNAMIC) {
+                const Collider::Box& anotherReach = this->reaches[another];
+                if (anotherReach.left > reach.right || anotherReach.right < reach.left ||
+                        anotherReach.bottom > reach.top || anotherReach.top < reach.bottom) {
                     continue;
                 }
 
-                Entity::EntityType anotherType = another->second->getType();
-                if ((anotherType == Entity::EntityType::TYPE_WEAPON || anotherType == Entity::EntityType::TYPE_PACK) &&
-                        (type == Entity::EntityType::TYPE_WEAPON || type == Entity::EntityType::TYPE_PACK)) {
-                    continue;
-                }
+                this->joinIslands(id, another);
+            }
 
-                if (anotherType == Entity::EntityType::TYPE_WEAPON) {
-                    auto weapon = std::dynamic_pointer_cast<Weapon>(another->second);
-                    if (weapon->getState() == Weapon::WeaponState::STATE_PICKED) {
-                        continue;
-                    }
-                }
+            this->neighbourIds.push_back(another);
+        }
+    }
 
-                Collider::CollideSide side = entity->second->getCollider()->collides(another->second->getCollider());
-                if (side != Collider::CollideSide::SIDE_NONE) {
-                    entity->second->onCollision(another->second, side);
-                }
+    this->neighbourOffsets[size] = this->neighbourIds.size();
 
-                if (((anotherType == Entity::EntityType::TYPE_WEAPON || anotherType == Entity::EntityType::TYPE_PACK) &&
-                        type == Entity::EntityType::TYPE_PLAYER) ||
-                        ((type == Entity::EntityType::TYPE_WEAPON || type == Entity::EntityType::TYPE_PACK) &&
-                        anotherType == Entity::EntityType::TYPE_PLAYER)) {
-                    continue;
-                }
+    // Roots are the lowest body id of their island, so islands come out in id order as well
+    this->islandOffsets.assign(1, 0);
+    this->islandIndexes.assign(size, -1);
 
-                Math::Vec3 speed = entity->second->getSpeed();
+    for (int id = 0; id < size; id++) {
+        if (this->bodies.flags[id] & BodyStorage::FLAG_DYNAMIC) {
+            int root = this->findIsland(id);
+            if (this->islandIndexes[root] == -1) {
+                this->islandIndexes[root] = this->islandOffsets.size() - 1;
+                this->islandOffsets.push_back(0);
+            }
 
-                if (side == Collider::CollideSide::SIDE_BOTTOM && speed.get(Math::Vec3::Y) < 0.0f) {
-                    speed.set(Math::Vec3::Y, 0.0f);
-                } else if (side == Collider::CollideSide::SIDE_TOP && speed.get(Math::Vec3::Y) > 0.0f) {
-                    speed.set(Math::Vec3::Y, 0.0f);
-                } else if (side == Collider::CollideSide::SIDE_LEFT && speed.get(Math::Vec3::X) < 0.0f) {
-                    speed.set(Math::Vec3::X, 0.0f);
-                } else if (side == Collider::CollideSide::SIDE_RIGHT && speed.get(Math::Vec3::X) > 0.0f) {
-                    speed.set(Math::Vec3::X, 0.0f);
-                }
+            this->islandOffsets[this->islandIndexes[root] + 1]++;
+        }
+    }
+
+    for (int island = 1; island < static_cast<int>(this->islandOffsets.size()); island++) {
+        this->islandOffsets[island] += this->islandOffsets[island - 1];
+    }
+
+    this->islandBodies.resize(this->islandOffsets.back());
+    this->islandCursors.assign(this->islandOffsets.begin(), this->islandOffsets.end() - 1);
+
+    for (int id = 0; id < size; id++) {
+        if (this->bodies.flags[id] & BodyStorage::FLAG_DYNAMIC) {
+            int island = this->islandIndexes[this->findIsland(id)];
+            this->islandBodies[this->islandCursors[island]++] = id;
+        }
+    }
+}
+
+int Scene::findIsland(int id) {
+    while (this->islandParents[id] != id) {
+        this->islandParents[id] = this->islandParents[this->islandParents[id]];
+        id = this->islandParents[id];
+    }
+
+    return id;
+}
+
+void Scene::joinIslands(int id, int another) {
+    int root = this->findIsland(id);
+    int anotherRoot = this->findIsland(another);
+
+    // Lower id wins, keeps roots independent of the visiting order
+    if (root < anotherRoot) {
+        this->islandParents[anotherRoot] = root;
+    } else if (anotherRoot < root) {
+        this->islandParents[root] = anotherRoot;
+    }
+}
+
+void Scene::packNeighbours(int id, Workspace& workspace) {
+    int firstNeighbour = this->neighbourOffsets[id];
+    int count = this->neighbourOffsets[id + 1] - firstNeighbour;
+
+    workspace.left.resize(count);
+    workspace.right.resize(count);
+    workspace.bottom.resize(count);
+    workspace.top.resize(count);
+    workspace.sides.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        Collider::Box box = this->bodies.getBox(this->neighbourIds[firstNeighbour + i]);
+        workspace.left[i] = box.left;
+        workspace.right[i] = box.right;
+        workspace.bottom[i] = box.bottom;
+        workspace.top[i] = box.top;
+    }
+}
+
+void Scene::applyContacts() {
+    PROFILE_ZONE("Scene::applyContacts");
+
+    this->contacts.clear();
+    for (auto& workspace: this->workspaces) {
+        this->contacts.insert(this->contacts.end(), workspace.contacts.begin(), workspace.contacts.end());
+        workspace.contacts.clear();
+    }
+
+    // A body's contacts all come from one workspace in order, sorting by body keeps it deterministic
+    std::stable_sort(this->contacts.begin(), this->contacts.end(),
+            [](const Contact& contact, const Contact& another) -> bool {
+        return contact.id < another.id;
+    });
+
+    for (auto& contact: this->contacts) {
+        std::shared_ptr<Entity> entity(this->bodies.entities[contact.id]);
+        std::shared_ptr<Entity> another(this->bodies.entities[contact.another]);
+        this->bodies.wake(contact.another);
+
+        // Earlier callbacks may have picked or destroyed either of them
+        if (entity->destroyed || !this->canCollide(entity, another)) {
+            continue;
+        }
+
+        // The step is over and the response already applied, show the speed of the touch instead
+        Math::Vec3 speed(entity->getSpeed());
+        entity->setSpeed(contact.speed);
+        entity->onCollision(another, contact.side);
+
+        if (entity->getSpeed() == contact.speed) {
+            entity->setSpeed(speed);  // Unless the callback changed it
+        }
+    }
+}
+
+void Scene::advance(const std::shared_ptr<Entity>& entity, float frameTime) {
+    entity->setSpeed(entity->getSpeed() + this->gravityAcceleration * frameTime);
+
+    // Everything we may touch until the frame ends
+    auto& collider = entity->getCollider();
+    Math::Vec3 motion(entity->getSpeed() * frameTime);
+    Math::Vec3 lowerBound(collider->getLowerBound());
+    Math::Vec3 upperBound(collider->getUpperBound());
+
+    if (motion.get(Math::Vec3::X) > 0.0f) {
+        upperBound.set(Math::Vec3::X, upperBound.get(Math::Vec3::X) + motion.get(Math::Vec3::X));
+    } else {
+        lowerBound.set(Math::Vec3::X, lowerBound.get(Math::Vec3::X) + motion.get(Math::Vec3::X));
+    }
+
+    if (motion.get(Math::Vec3::Y) > 0.0f) {
+        upperBound.set(Math::Vec3::Y, upperBound.get(Math::Vec3::Y) + motion.get(Math::Vec3::Y));
+    } else {
+        lowerBound.set(Math::Vec3::Y, lowerBound.get(Math::Vec3::Y) + motion.get(Math::Vec3::Y));
+    }
+
+    this->candidates.clear();
+    if (this->broadPhaseType == BroadPhaseType::TYPE_SPATIAL_HASH) {
+        this->staticIndex.query(lowerBound, upperBound, this->candidates);
+        this->spatialHash.query(lowerBound, upperBound, entity.get(), this->candidates);
+    } else {
+        for (auto& another: this->bodies.entities) {
+            this->candidates.push_back(another);
+        }
+    }
+
+    float remainingTime = frameTime;
+    this->notified.assign(this->candidates.size(), false);
+
+    for (int i = 0; i < MAX_SWEEP_ITERATIONS && remainingTime > 0.0f; i++) {
+        // Touching contacts get the very same response substeps give them, callbacks once per frame
+        for (size_t j = 0; j < this->candidates.size(); j++) {
+            bool notified = this->notified[j];
+            this->collide(entity, this->candidates[j], notified);
+            this->notified[j] = notified;
+        }
+
+        motion = entity->getSpeed() * remainingTime;
+        float impactTime = 1.0f;
+        Math::Vec3 impactDirection(Math::Vec3::ZERO);
 
-                entity->second->setSpeed(speed);
+        for (auto& another: this->candidates) {
+            if (!this->canCollide(entity, another) || !this->canBlock(entity, another)) {
+                continue;
             }
 
-            entity->second->setPosition(entity->second->getPosition() + entity->second->getSpeed() * step);
-            step = (frameTime - totalTime > frameStep) ? frameStep : frameTime - totalTime;
+            Math::Vec3 direction;
+            float time = collider->sweep(another->getCollider(), motion, direction);
+            if (time < impactTime) {
+                impactTime = time;
+                impactDirection = direction;
+            }
         }
+
+        entity->setPosition(entity->getPosition() + motion * impactTime + impactDirection * SWEEP_SKIN);
+        remainingTime -= remainingTime * impactTime;
     }
+}
 
-    for (auto entity = this->entities.begin(); entity != this->entities.end(); ) {
-        if (entity->second->destroyed) {
-            Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Entity %p destroyed", entity->second.get());
-            entity->second->scene.reset();
-            this->entities.erase(entity++);
-        } else {
-            entity->second->animate(frameTime);
-            ++entity;
+void Scene::collide(const std::shared_ptr<Entity>& entity, const std::shared_ptr<Entity>& another, bool& notified) {
+    PROFILE_ZONE("Scene::collide");
+
+    if (!this->canCollide(entity, another)) {
+        return;
+    }
+
+    Collider::CollideSide side = entity->getCollider()->collides(another->getCollider());
+    if (side != Collider::CollideSide::SIDE_NONE && !notified) {
+        this->bodies.wake(another->bodyId);
+        entity->onCollision(another, side);
+        notified = true;
+    }
+
+    if (!this->canBlock(entity, another)) {
+        return;
+    }
+
+    if (side == Collider::CollideSide::SIDE_BOTTOM) {
+        this->bodies.flags[entity->bodyId] |= BodyStorage::FLAG_RESTING;
+    }
+
+    Math::Vec3 speed = entity->getSpeed();
+
+    if (side == Collider::CollideSide::SIDE_BOTTOM && speed.get(Math::Vec3::Y) < 0.0f) {
+        speed.set(Math::Vec3::Y, 0.0f);
+    } else if (side == Collider::CollideSide::SIDE_TOP && speed.get(Math::Vec3::Y) > 0.0f) {
+        speed.set(Math::Vec3::Y, 0.0f);
+    } else if (side == Collider::CollideSide::SIDE_LEFT && speed.get(Math::Vec3::X) < 0.0f) {
+        speed.set(Math::Vec3::X, 0.0f);
+    } else if (side == Collider::CollideSide::SIDE_RIGHT && speed.get(Math::Vec3::X) > 0.0f) {
+        speed.set(Math::Vec3::X, 0.0f);
+    }
+
+    entity->setSpeed(speed);
+}
+
+bool Scene::canCollide(const std::shared_ptr<Entity>& entity, const std::shared_ptr<Entity>& another) const {
+    if (another->destroyed || !another->isCollidable()) {
+        return false;
+    }
+
+    if (!(another->getCategory() & entity->getCollisionMask()) ||
+            !(entity->getCategory() & another->getCollisionMask())) {
+        return false;
+    }
+
+    if (another->getType() == Entity::EntityType::TYPE_WEAPON) {
+        auto weapon = static_cast<const Weapon*>(another.get());
+        if (weapon->getState() == Weapon::WeaponState::STATE_PICKED) {
+            return false;
         }
     }
+
+    return true;
+}
+
+bool Scene::canCollide(int id, int another) const {
+    if (!(this->bodies.flags[another] & BodyStorage::FLAG_COLLIDABLE)) {
+        return false;
+    }
+
+    // Both sides have to accept each other
+    return (this->bodies.categories[another] & this->bodies.collisionMasks[id]) &&
+           (this->bodies.categories[id] & this->bodies.collisionMasks[another]);
+}
+
+bool Scene::canBlock(int id, int another) const {
+    return (this->bodies.categories[another] & this->bodies.blockingMasks[id]) &&
+           (this->bodies.categories[id] & this->bodies.blockingMasks[another]);
+}
+
+bool Scene::canBlock(const std::shared_ptr<Entity>& entity, const std::shared_ptr<Entity>& another) const {
+    return (another->getCategory() & entity->getBlockingMask()) &&
+           (entity->getCategory() & another->getBlockingMask());
 }
 
 }  // namespace Game
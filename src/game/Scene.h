@@ -26,24 +26,126 @@
 #include "NonCopyable.h"
 #include "Camera.h"
 #include "Entity.h"
+#include "Player.h"
+#include "Weapon.h"
+#include "Pack.h"
+#include "Widget.h"
+#include "SpatialHash.h"
+#include "StaticIndex.h"
+#include "BodyStorage.h"
+#include "HandleTable.h"
+#include "RayGrid.h"
 #include "RenderEffect.h"
+#include "SpriteBatch.h"
+#include "ThreadPool.h"
 
 #include <Vec3.h>
 #include <Label.h>
 #include <memory>
-#include <map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 #include <algorithm>
+#include <random>
 
 namespace PolandBall {
 
 namespace Game {
 
-class Scene: public std::enable_shared_from_this<Scene>, public Common::NonCopyable {
+class Scene: public Common::NonCopyable {
 public:
+    enum BroadPhaseType {
+        TYPE_NAIVE,         // Every entity against every other
+        TYPE_SPATIAL_HASH   // Only entities sharing grid cells
+    };
+
+    typedef struct {
+        Entity* entity;  // nullptr if nothing was hit
+        float distance;
+        Math::Vec3 point;
+    } RayHit;
+
+    enum SolverType {
+        TYPE_SUBSTEP,       // Fixed frameStep integration, collisions tested every step
+        TYPE_CONTINUOUS     // Swept collisions, one step per impact
+    };
+
     Scene():
+            workspaces(1),
+            threadPool(new Utils::ThreadPool(1)),
             gravityAcceleration(0.0f, -35.0f, 0.0f) {
+        this->broadPhaseType = TYPE_SPATIAL_HASH;
+        this->solverType = TYPE_SUBSTEP;
+        this->sleepSpeed = 0.05f;
+        this->awakeBodies = 0;
+        this->sleepingBodies = 0;
+        this->rayGridDirty = false;
+        this->cameraTarget = HandleTable::NONE;
+        this->drawCalls = 0;
+    }
+
+    ~Scene();
+
+    BroadPhaseType getBroadPhaseType() const {
+        return this->broadPhaseType;
+    }
+
+    void setBroadPhaseType(BroadPhaseType broadPhaseType) {
+        this->broadPhaseType = broadPhaseType;
+    }
+
+    SolverType getSolverType() const {
+        return this->solverType;
+    }
+
+    void setSolverType(SolverType solverType) {
+        this->solverType = solverType;
+    }
+
+    float getSleepSpeed() const {
+        return this->sleepSpeed;
+    }
+
+    // Bodies slower than that along both axes while resting on something fall asleep
+    void setSleepSpeed(float sleepSpeed) {
+        this->sleepSpeed = sleepSpeed;
+    }
+
+    // Bodies simulated during the last update
+    int getAwakeBodies() const {
+        return this->awakeBodies;
+    }
+
+    // Bodies skipped during the last update
+    int getSleepingBodies() const {
+        return this->sleepingBodies;
+    }
+
+    // Gameplay randomness comes from here so a seed and the input reproduce a session
+    void setSeed(unsigned int seed) {
+        this->random.seed(seed);
+    }
+
+    // Uniform in [0, 1)
+    float getRandom() {
+        return (this->random() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Digest of the gameplay state, equal across runs that simulated the same thing
+    unsigned long long getStateHash() const;
+
+    int getThreads() const {
+        return this->threadPool->getThreads();
+    }
+
+    // More than one thread steps independent islands concurrently and defers onCollision calls
+    void setThreads(int threads) {
+        if (threads < 1) {
+            threads = 1;
+        }
+
+        this->threadPool.reset(new Utils::ThreadPool(threads));
+        this->workspaces.resize(threads);
     }
 
     void setGravityAcceleration(const Math::Vec3& gravityAcceleration) {
@@ -56,13 +158,12 @@ public:
 
     void setCamera(const Camera& camera) {
         this->camera = camera;
+        this->previousCameraPosition = camera.getPosition();
 
-        for (auto& entity: this->entities) {
-            if (entity.first == Entity::EntityType::TYPE_WIDGET) {
-                auto label = std::dynamic_pointer_cast<Label>(entity.second);
-                if (label != nullptr) {
-                    label->setProjection(this->camera.getProjection());
-                }
+        for (auto& widget: this->widgets) {
+            auto label = std::dynamic_pointer_cast<Label>(widget);
+            if (label != nullptr) {
+                label->setProjection(this->camera.getProjection());
             }
         }
     }
@@ -71,19 +172,167 @@ public:
         return this->camera;
     }
 
+    // Camera follows the entity, moved along with attached entities
+    void setCameraTarget(EntityHandle cameraTarget) {
+        this->cameraTarget = cameraTarget;
+        this->updateTransforms();
+    }
+
+    EntityHandle getCameraTarget() const {
+        return this->cameraTarget;
+    }
+
     void addEntity(const std::shared_ptr<Entity>& entity);
 
-    void render();
+    // Drawn over the world in pixels from the bottom left corner, never moved nor collided by the scene
+    void addOverlay(const std::shared_ptr<Widget>& widget);
+
+    // Pixel space of the overlay
+    void setViewport(int width, int height);
+
+    // Textured sprites drawn with spriteEffect are batched per texture and drawn with batchEffect instead
+    void setBatchEffect(const std::shared_ptr<Opengl::RenderEffect>& spriteEffect,
+            const std::shared_ptr<Opengl::RenderEffect>& batchEffect);
+
+    // Issued by the last render()
+    int getDrawCalls() const {
+        return this->drawCalls;
+    }
+
+    // nullptr once the entity is destroyed
+    Entity* getEntity(EntityHandle handle) const {
+        return this->handles.get(handle);
+    }
+
+    // First collidable entity of a mask layer along the normalized direction, except the given one
+    bool raycast(const Math::Vec3& from, const Math::Vec3& direction, float maxDistance, unsigned int mask,
+            RayHit& hit, const Entity* except = nullptr);
+
+    // alpha blends the last two update() states, 1.0 renders the latest one
+    void render(float alpha = 1.0f);
     void update(float frameTime, float frameStep);
 
 private:
-    std::multimap<Entity::EntityType, std::shared_ptr<Entity>> entities;
+    friend class Entity;
+
+    enum {
+        MAX_SWEEP_ITERATIONS = 4,
+        SLEEP_FRAMES = 10  // Resting frames before a body falls asleep
+    };
+
+    // How deep a sweep leaves a body in what it hit, so collides() reports the touch on the next pass
+    static constexpr float SWEEP_SKIN = 0.0001f;
+
+    typedef struct {
+        int id;
+        int another;
+        Collider::CollideSide side;
+        Math::Vec3 speed;  // Of the body when it touched, before the response stopped it
+    } Contact;
+
+    // Per thread scratch space of simulate()
+    typedef struct {
+        std::vector<float> left;  // Neighbour boxes packed for Collider::classify batches
+        std::vector<float> right;
+        std::vector<float> bottom;
+        std::vector<float> top;
+        std::vector<Collider::CollideSide> sides;
+        std::vector<Contact> contacts;  // Deferred onCollision calls
+    } Workspace;
+
+    void attach(Entity* entity);
+    void updateTransforms();
+    void resolveTransform(Entity* entity);
+    void renderEntity(Entity* entity, float alpha);
+    void flushBatch(float alpha);
+    void removeEntity(Entity* entity);
+    template <typename T>
+    void updateEntities(std::vector<std::shared_ptr<T>>& bucket, float frameTime);
+    void updateBounds(Entity* entity);
+    void simulate(int id, float frameTime, float frameStep, Workspace& workspace, bool deferred);
+    void buildIslands(float frameTime);
+    int findIsland(int id);
+    void joinIslands(int id, int another);
+    void packNeighbours(int id, Workspace& workspace);
+    void applyContacts();
+    void updateSleep();
+    void advance(const std::shared_ptr<Entity>& entity, float frameTime);
+    void collide(const std::shared_ptr<Entity>& entity, const std::shared_ptr<Entity>& another, bool& notified);
+
+    bool canCollide(const std::shared_ptr<Entity>& entity, const std::shared_ptr<Entity>& another) const;
+    bool canBlock(const std::shared_ptr<Entity>& entity, const std::shared_ptr<Entity>& another) const;
+    bool canCollide(int id, int another) const;
+    bool canBlock(int id, int another) const;
+
+    // Entities by type, rendered in EntityType order
+    std::vector<std::shared_ptr<Entity>> generics;
+    std::vector<std::shared_ptr<Player>> players;
+    std::vector<std::shared_ptr<Weapon>> weapons;
+    std::vector<std::shared_ptr<Pack>> packs;
+    std::vector<std::shared_ptr<Widget>> widgets;
+    std::vector<std::shared_ptr<Widget>> overlay;
     std::unordered_set<std::shared_ptr<Opengl::RenderEffect>> effects;
+    std::unordered_set<std::shared_ptr<Opengl::RenderEffect>> overlayEffects;
+    Math::Mat4 overlayProjection;
+    Opengl::SpriteBatch batch;
+    std::shared_ptr<Opengl::RenderEffect> batchedEffect;
+    std::vector<Entity*> unbatched;  // Drawn one by one after the batch of their bucket
+    int drawCalls;
+
+    HandleTable handles;
+    std::vector<EntityHandle> attached;  // Entities following a parent, stale ones pruned lazily
+    EntityHandle cameraTarget;
+    SpatialHash spatialHash;
+    StaticIndex staticIndex;
+    RayGrid rayGrid;  // Collidable bodies for raycast(), rebuilt lazily
+    bool rayGridDirty;
+    BodyStorage bodies;
+    std::vector<std::shared_ptr<Entity>> candidates;
+    std::vector<char> notified;  // Candidates whose onCollision already ran this frame
+    std::vector<Collider::Box> reaches;  // Where each dynamic body may get this frame
+    std::vector<int> neighbourIds;       // Bodies a dynamic one may touch, ranged by neighbourOffsets
+    std::vector<int> neighbourOffsets;
+    std::vector<int> islandParents;      // Union-find over dynamic bodies
+    std::vector<int> islandIndexes;
+    std::vector<int> islandCursors;
+    std::vector<int> islandBodies;       // Dynamic bodies grouped by island, ranged by islandOffsets
+    std::vector<int> islandOffsets;
+    std::vector<Contact> contacts;
+    std::vector<Workspace> workspaces;
+    std::unique_ptr<Utils::ThreadPool> threadPool;
+    BroadPhaseType broadPhaseType;
+    SolverType solverType;
+    float sleepSpeed;
+    int awakeBodies;
+    int sleepingBodies;
+    std::mt19937 random;
 
     Math::Vec3 gravityAcceleration;
     Camera camera;
+    Math::Vec3 previousCameraPosition;
 };
 
+template <typename T>
+void Scene::updateEntities(std::vector<std::shared_ptr<T>>& bucket, float frameTime) {
+    // Indexes, animate() may add entities and grow the bucket
+    int last = 0;
+    for (int i = 0; i < static_cast<int>(bucket.size()); i++) {
+        Entity* entity = bucket[i].get();
+
+        if (entity->destroyed) {
+            this->removeEntity(entity);
+        } else {
+            entity->animate(frameTime);
+            if (last != i) {
+                bucket[last] = std::move(bucket[i]);
+            }
+            last++;
+        }
+    }
+
+    bucket.resize(last);
+}
+
 }  // namespace Game
 
 }  // namespace PolandBall
@@ -26,6 +26,18 @@ namespace PolandBall {
 
 namespace Game {
 
+void ShotTrace::reset(const Math::Vec3& from, const Math::Vec3& to) {
+    this->line->setEnds(from, to);
+    this->transparency = 1.0f;
+    this->lifeTime = 0.0f;
+    this->fadeTime = 0.0f;
+    this->destroyed = false;
+
+    Math::Vec4 color = this->line->getColor();
+    color.set(Math::Vec4::W, this->transparency);
+    this->line->setColor(color);
+}
+
 void ShotTrace::animate(float frameTime) {
     if (this->lifeTime < this->maxLifeTime) {
         this->lifeTime += frameTime;
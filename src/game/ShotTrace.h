@@ -35,19 +35,17 @@ namespace Game {
 class ShotTrace: public LineEntity {
 public:
     ShotTrace(const Math::Vec3& from, const Math::Vec3& to) {
-        this->transparency = 1.0f;
         this->maxLifeTime = 0.1f;
         this->maxFadeTime = 0.2f;
-
-        this->line->setFrom(from);
-        this->line->setTo(to);
-        this->lifeTime = 0.0f;
-        this->fadeTime = 0.0f;
+        this->reset(from, to);
 
         this->collidable = false;
-        this->type = Entity::EntityType::TYPE_GENERIC;
+        this->setType(Entity::EntityType::TYPE_GENERIC);
     }
 
+    // Starts over as a fresh trace, lets TracePool recycle destroyed ones
+    void reset(const Math::Vec3& from, const Math::Vec3& to);
+
     float getLifeTime() const {
         return this->maxLifeTime;
     }
@@ -64,6 +62,11 @@ public:
         this->maxFadeTime = maxFadeTime;
     }
 
+    // Seconds from creation to destruction
+    float getDuration() const {
+        return this->maxLifeTime + this->maxFadeTime;
+    }
+
 private:
     void animate(float frameTime);
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "SpatialHash.h"
+#include "Entity.h"
+
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+namespace PolandBall {
+
+namespace Game {
+
+void SpatialHash::insert(const std::shared_ptr<Entity>& entity) {
+    if (entity == nullptr || this->records.find(entity.get()) != this->records.end()) {
+        return;
+    }
+
+    std::unique_ptr<Record> record(new Record());
+    record->entity = entity;
+    record->cells = this->getCells(entity->getCollider()->getLowerBound(), entity->getCollider()->getUpperBound());
+    record->stamp = this->queryStamp;
+
+    this->link(record.get());
+    this->records.insert(std::make_pair(entity.get(), std::move(record)));
+}
+
+void SpatialHash::update(const Entity* entity) {
+    auto record = this->records.find(entity);
+    if (record == this->records.end()) {
+        return;
+    }
+
+    CellRange cells = this->getCells(entity->getCollider()->getLowerBound(), entity->getCollider()->getUpperBound());
+    CellRange& current = record->second->cells;
+
+    // Most moves stay within the same cells, nothing to relink then
+    if (cells.minX == current.minX && cells.minY == current.minY &&
+            cells.maxX == current.maxX && cells.maxY == current.maxY) {
+        return;
+    }
+
+    this->unlink(record->second.get());
+    current = cells;
+    this->link(record->second.get());
+}
+
+void SpatialHash::remove(const Entity* entity) {
+    auto record = this->records.find(entity);
+    if (record == this->records.end()) {
+        return;
+    }
+
+    this->unlink(record->second.get());
+    this->records.erase(record);
+}
+
+void SpatialHash::clear() {
+    this->cells.clear();
+    this->records.clear();
+}
+
+void SpatialHash::query(const Entity* entity, std::vector<std::shared_ptr<Entity>>& result) {
+    auto record = this->records.find(entity);
+    if (record != this->records.end()) {
+        this->query(record->second->cells, entity, result);
+    } else {
+        this->query(entity->getCollider()->getLowerBound(), entity->getCollider()->getUpperBound(), entity, result);
+    }
+}
+
+void SpatialHash::query(const Math::Vec3& lowerBound, const Math::Vec3& upperBound, const Entity* except,
+        std::vector<std::shared_ptr<Entity>>& result) {
+    this->query(this->getCells(lowerBound, upperBound), except, result);
+}
+
+void SpatialHash::query(const CellRange& range, const Entity* except, std::vector<std::shared_ptr<Entity>>& result) {
+    // Entities spanning several cells are reported once per query
+    this->queryStamp++;
+
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            auto cell = this->cells.find(SpatialHash::getKey(x, y));
+            if (cell == this->cells.end()) {
+                continue;
+            }
+
+            for (auto another: cell->second) {
+                if (another->stamp != this->queryStamp && another->entity.get() != except) {
+                    another->stamp = this->queryStamp;
+                    result.push_back(another->entity);
+                }
+            }
+        }
+    }
+}
+
+SpatialHash::CellRange SpatialHash::getCells(const Math::Vec3& lowerBound, const Math::Vec3& upperBound) const {
+    CellRange range;
+    range.minX = static_cast<int>(floorf(lowerBound.get(Math::Vec3::X) / this->cellSize));
+    range.minY = static_cast<int>(floorf(lowerBound.get(Math::Vec3::Y) / this->cellSize));
+    range.maxX = static_cast<int>(floorf(upperBound.get(Math::Vec3::X) / this->cellSize));
+    range.maxY = static_cast<int>(floorf(upperBound.get(Math::Vec3::Y) / this->cellSize));
+
+    return range;
+}
+
+void SpatialHash::link(Record* record) {
+    for (int x = record->cells.minX; x <= record->cells.maxX; x++) {
+        for (int y = record->cells.minY; y <= record->cells.maxY; y++) {
+            this->cells[SpatialHash::getKey(x, y)].push_back(record);
+        }
+    }
+}
+
+void SpatialHash::unlink(Record* record) {
+    for (int x = record->cells.minX; x <= record->cells.maxX; x++) {
+        for (int y = record->cells.minY; y <= record->cells.maxY; y++) {
+            auto cell = this->cells.find(SpatialHash::getKey(x, y));
+            if (cell == this->cells.end()) {
+                continue;
+            }
+
+            auto position = std::find(cell->second.begin(), cell->second.end(), record);
+            if (position != cell->second.end()) {
+                *position = cell->second.back();
+                cell->second.pop_back();
+            }
+
+            if (cell->second.empty()) {
+                this->cells.erase(cell);
+            }
+        }
+    }
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include "NonCopyable.h"
+#include "Collider.h"
+
+#include <Vec3.h>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+namespace PolandBall {
+
+namespace Game {
+
+class Entity;
+
+// Uniform grid broad phase: entities are bucketed by the cells their collide box covers
+class SpatialHash: public Common::NonCopyable {
+public:
+    SpatialHash():
+            SpatialHash(2.0f) {
+    }
+
+    SpatialHash(float cellSize) {
+        this->cellSize = cellSize;
+        this->queryStamp = 0;
+    }
+
+    float getCellSize() const {
+        return this->cellSize;
+    }
+
+    void insert(const std::shared_ptr<Entity>& entity);
+    void update(const Entity* entity);
+    void remove(const Entity* entity);
+    void clear();
+
+    // Appends every entity sharing at least one cell with the given one (except itself)
+    void query(const Entity* entity, std::vector<std::shared_ptr<Entity>>& result);
+    void query(const Math::Vec3& lowerBound, const Math::Vec3& upperBound, const Entity* except,
+            std::vector<std::shared_ptr<Entity>>& result);
+
+private:
+    typedef struct {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    } CellRange;
+
+    typedef struct {
+        std::shared_ptr<Entity> entity;
+        CellRange cells;
+        unsigned int stamp;
+    } Record;
+
+    static long long getKey(int x, int y) {
+        return (static_cast<long long>(x) << 32) | static_cast<unsigned int>(y);
+    }
+
+    CellRange getCells(const Math::Vec3& lowerBound, const Math::Vec3& upperBound) const;
+    void query(const CellRange& range, const Entity* except, std::vector<std::shared_ptr<Entity>>& result);
+
+    void link(Record* record);
+    void unlink(Record* record);
+
+    std::unordered_map<long long, std::vector<Record*>> cells;
+    std::unordered_map<const Entity*, std::unique_ptr<Record>> records;
+
+    float cellSize;
+    unsigned int queryStamp;
+};
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // SPATIALHASH_H
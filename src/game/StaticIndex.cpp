@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "StaticIndex.h"
+#include "Entity.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace PolandBall {
+
+namespace Game {
+
+void StaticIndex::insert(const std::shared_ptr<Entity>& entity) {
+    if (entity == nullptr) {
+        return;
+    }
+
+    Item item;
+    item.entity = entity;
+
+    this->items.push_back(item);
+    this->dirty = true;
+}
+
+std::shared_ptr<Entity> StaticIndex::remove(const Entity* entity) {
+    auto item = std::find_if(this->items.begin(), this->items.end(), [entity](const Item& item) -> bool {
+        return item.entity.get() == entity;
+    });
+
+    if (item == this->items.end()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Entity> removed(item->entity);
+    this->items.erase(item);
+
+    // Nodes refer to items by position, rebuild right away to keep queries valid
+    this->dirty = true;
+    this->build();
+
+    return removed;
+}
+
+void StaticIndex::clear() {
+    this->items.clear();
+    this->nodes.clear();
+    this->dirty = false;
+}
+
+void StaticIndex::build() {
+    if (!this->dirty) {
+        return;
+    }
+
+    for (auto& item: this->items) {
+        Math::Vec3 lowerBound = item.entity->getCollider()->getLowerBound();
+        Math::Vec3 upperBound = item.entity->getCollider()->getUpperBound();
+
+        item.minX = lowerBound.get(Math::Vec3::X);
+        item.minY = lowerBound.get(Math::Vec3::Y);
+        item.maxX = upperBound.get(Math::Vec3::X);
+        item.maxY = upperBound.get(Math::Vec3::Y);
+    }
+
+    this->nodes.clear();
+    this->nodes.reserve(this->items.size() * 2);
+
+    if (!this->items.empty()) {
+        this->buildNode(0, this->items.size());
+    }
+
+    this->dirty = false;
+}
+
+void StaticIndex::query(const Math::Vec3& lowerBound, const Math::Vec3& upperBound,
+        std::vector<std::shared_ptr<Entity>>& result) const {
+    if (this->nodes.empty()) {
+        return;
+    }
+
+    float minX = lowerBound.get(Math::Vec3::X);
+    float minY = lowerBound.get(Math::Vec3::Y);
+    float maxX = upperBound.get(Math::Vec3::X);
+    float maxY = upperBound.get(Math::Vec3::Y);
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        int index = stack[--top];
+        const Node& node = this->nodes[index];
+        if (node.minX > maxX || node.maxX < minX || node.minY > maxY || node.maxY < minY) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                const Item& item = this->items[i];
+                if (item.minX <= maxX && item.maxX >= minX && item.minY <= maxY && item.maxY >= minY) {
+                    result.push_back(item.entity);
+                }
+            }
+        } else {
+            stack[top++] = node.right;
+            stack[top++] = index + 1;
+        }
+    }
+}
+
+int StaticIndex::buildNode(int first, int count) {
+    int index = this->nodes.size();
+    this->nodes.push_back(Node());
+
+    float minX = FLT_MAX, minY = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+    for (int i = first; i < first + count; i++) {
+        minX = std::min(minX, this->items[i].minX);
+        minY = std::min(minY, this->items[i].minY);
+        maxX = std::max(maxX, this->items[i].maxX);
+        maxY = std::max(maxY, this->items[i].maxY);
+    }
+
+    int right = -1;
+
+    if (count > MAX_LEAF_SIZE) {
+        // Median split along the longest axis keeps the tree balanced (and shallow)
+        bool splitX = (maxX - minX) >= (maxY - minY);
+        auto begin = this->items.begin() + first;
+
+        std::nth_element(begin, begin + count / 2, begin + count, [splitX](const Item& a, const Item& b) -> bool {
+            return splitX ? (a.minX + a.maxX < b.minX + b.maxX) : (a.minY + a.maxY < b.minY + b.maxY);
+        });
+
+        this->buildNode(first, count / 2);
+        right = this->buildNode(first + count / 2, count - count / 2);
+    }
+
+    Node& node = this->nodes[index];
+    node.minX = minX;
+    node.minY = minY;
+    node.maxX = maxX;
+    node.maxY = maxY;
+    node.right = right;
+    node.first = first;
+    node.count = (count > MAX_LEAF_SIZE) ? 0 : count;
+
+    return index;
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
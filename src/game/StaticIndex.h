@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef STATICINDEX_H
+#define STATICINDEX_H
+
+#include "NonCopyable.h"
+
+#include <Vec3.h>
+#include <vector>
+#include <memory>
+
+namespace PolandBall {
+
+namespace Game {
+
+class Entity;
+
+// Bulk-loaded bounding volume hierarchy over entities that never move
+class StaticIndex: public Common::NonCopyable {
+public:
+    StaticIndex() {
+        this->dirty = false;
+    }
+
+    void insert(const std::shared_ptr<Entity>& entity);
+    std::shared_ptr<Entity> remove(const Entity* entity);
+    void clear();
+
+    // Rebuilds the hierarchy if entities were inserted since the last call
+    void build();
+
+    // Appends every entity whose bounds overlap or touch the given box
+    void query(const Math::Vec3& lowerBound, const Math::Vec3& upperBound,
+            std::vector<std::shared_ptr<Entity>>& result) const;
+
+    int getSize() const {
+        return this->items.size();
+    }
+
+private:
+    enum {
+        MAX_LEAF_SIZE = 2
+    };
+
+    typedef struct {
+        float minX;
+        float minY;
+        float maxX;
+        float maxY;
+        std::shared_ptr<Entity> entity;
+    } Item;
+
+    typedef struct {
+        float minX;
+        float minY;
+        float maxX;
+        float maxY;
+        int right;  // Left child always follows its parent
+        int first;
+        int count;  // Non-zero for leaves only
+    } Node;
+
+    int buildNode(int first, int count);
+
+    std::vector<Item> items;
+    std::vector<Node> nodes;
+    bool dirty;
+};
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // STATICINDEX_H
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "StressTest.h"
+#include "Scene.h"
+#include "EntityFactory.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PolandBall {
+
+namespace Game {
+
+bool StressTest::populate(Scene& scene) {
+    static const char* weaponAssets[] = {
+        "assets/weapons/ak74.asset",
+        "assets/weapons/beretta92.asset",
+        "assets/weapons/knife.asset",
+        "assets/weapons/m1911.asset",
+        "assets/weapons/m4a1.asset",
+        "assets/weapons/wrench.asset"
+    };
+
+    static const char* packAssets[] = {
+        "assets/items/pack_armor.asset",
+        "assets/items/pack_health.asset",
+        "assets/items/pack_primary_ammo.asset",
+        "assets/items/pack_secondary_ammo.asset"
+    };
+
+    EntityFactory& factory = EntityFactory::getInstance();
+    float left = FIRST_SEGMENT + this->step * SEGMENT_WIDTH;
+
+    // Spread over the segment, snapped to half units so boxes rest on each other exactly
+    auto randomX = [&scene, left]() -> float {
+        return left + floorf(scene.getRandom() * SEGMENT_WIDTH * 2.0f) * 0.5f;
+    };
+    auto randomY = [&scene]() -> float {
+        return floorf(scene.getRandom() * SEGMENT_HEIGHT * 2.0f) * 0.5f;
+    };
+
+    auto floor = factory.createBlock("assets/blocks/kazakhstan.asset");
+    if (floor == nullptr) {
+        return false;
+    }
+
+    floor->setPosition(left + SEGMENT_WIDTH / 2.0f, -2.0f, 0.0f);
+    floor->scaleX(SEGMENT_WIDTH);
+    floor->getSprite()->replicateX(SEGMENT_WIDTH / 1.5f);
+    scene.addEntity(floor);
+
+    for (int i = 0; i < this->counts.blocks; i++) {
+        auto block = factory.createBlock("assets/blocks/kazakhstan.asset");
+        if (block == nullptr) {
+            return false;
+        }
+
+        float tiles = 1.0f + floorf(scene.getRandom() * 3.0f);
+        block->setPosition(randomX(), randomY(), 0.0f);
+        block->scaleX(1.5f * tiles);  // Scale for aspect ratio
+        block->getSprite()->replicateX(tiles);
+        scene.addEntity(block);
+    }
+
+    for (int i = 0; i < this->counts.weapons; i++) {
+        auto weapon = factory.createWeapon(weaponAssets[i % 6]);
+        if (weapon == nullptr) {
+            return false;
+        }
+
+        weapon->setPosition(randomX(), SEGMENT_HEIGHT, 0.0f);
+        scene.addEntity(weapon);
+    }
+
+    for (int i = 0; i < this->counts.packs; i++) {
+        auto pack = factory.createPack(packAssets[i % 4]);
+        if (pack == nullptr) {
+            return false;
+        }
+
+        pack->setPosition(randomX(), SEGMENT_HEIGHT, 0.0f);
+        scene.addEntity(pack);
+    }
+
+    for (int i = 0; i < this->counts.players; i++) {
+        auto player = factory.createPlayer("assets/players/turkey.asset");
+        if (player == nullptr) {
+            return false;
+        }
+
+        player->setPosition(randomX(), SEGMENT_HEIGHT, 0.0f);
+        scene.addEntity(player);
+        this->bots.push_back(Bot(player->getHandle()));
+    }
+
+    this->step++;
+    this->samples.clear();
+    return true;
+}
+
+void StressTest::think(Scene& scene, float frameTime) {
+    for (auto& bot: this->bots) {
+        bot.think(scene, frameTime);
+    }
+}
+
+void StressTest::report(const Scene& scene) {
+    if (this->samples.empty()) {
+        return;
+    }
+
+    std::sort(this->samples.begin(), this->samples.end());
+    auto percentile = [this](float rank) -> float {
+        return this->samples[static_cast<int>(rank * (this->samples.size() - 1))] * 1000.0f;
+    };
+
+    Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO,
+            "Stress step %d: %d dynamic bodies (%d asleep), %d bots, %zu frames: "
+            "p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms",
+            this->step, scene.getAwakeBodies() + scene.getSleepingBodies(), scene.getSleepingBodies(),
+            this->step * this->counts.players, this->samples.size(),
+            percentile(0.5f), percentile(0.9f), percentile(0.99f), percentile(1.0f));
+    this->samples.clear();
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
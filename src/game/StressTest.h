@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef STRESSTEST_H
+#define STRESSTEST_H
+
+#include "NonCopyable.h"
+#include "Bot.h"
+
+#include <vector>
+
+namespace PolandBall {
+
+namespace Game {
+
+class Scene;
+
+// Grows a level segment by segment and reports frame times at each size
+class StressTest: public Common::NonCopyable {
+public:
+    // Entities added by every step
+    typedef struct {
+        int blocks;
+        int weapons;
+        int packs;
+        int players;
+    } Counts;
+
+    StressTest(const Counts& counts) {
+        this->counts = counts;
+        this->step = 0;
+    }
+
+    const Counts& getCounts() const {
+        return this->counts;
+    }
+
+    int getStep() const {
+        return this->step;
+    }
+
+    // Another segment right of the previous one, the level density stays the same
+    bool populate(Scene& scene);
+    void think(Scene& scene, float frameTime);
+
+    void addSample(float frameTime) {
+        this->samples.push_back(frameTime);
+    }
+
+    // Logs frame time percentiles of the samples taken since the last report
+    void report(const Scene& scene);
+
+private:
+    enum {
+        SEGMENT_WIDTH = 40,
+        SEGMENT_HEIGHT = 8,
+        FIRST_SEGMENT = 16  // Right of the level floor
+    };
+
+    Counts counts;
+    int step;
+    std::vector<Bot> bots;
+    std::vector<float> samples;
+};
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // STRESSTEST_H
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "TracePool.h"
+#include "PoolAllocator.h"
+#include "Logger.h"
+
+#include <cmath>
+
+namespace PolandBall {
+
+namespace Game {
+
+void TracePool::reserve(float firingSpeed) {
+    if (firingSpeed <= 0.0f) {
+        return;
+    }
+
+    if (this->getSize() >= MAX_TRACES) {
+        return;
+    }
+
+    auto trace = this->create(Math::Vec3::ZERO, Math::Vec3::ZERO);
+    int count = ceilf(firingSpeed * trace->getDuration());
+
+    for (int i = 1; i < count && this->getSize() < MAX_TRACES; i++) {
+        this->create(Math::Vec3::ZERO, Math::Vec3::ZERO);
+    }
+
+    Utils::Logger::getInstance().log(Utils::Logger::LOG_INFO, "Reserved %d shot traces, %d total",
+            count, this->getSize());
+}
+
+void TracePool::clear() {
+    this->traces.clear();
+    this->effect.reset();
+    this->cursor = 0;
+}
+
+std::shared_ptr<ShotTrace> TracePool::acquire(const Math::Vec3& from, const Math::Vec3& to) {
+    int size = this->getSize();
+
+    for (int i = 0; i < size; i++) {
+        auto& trace = this->traces[(this->cursor + i) % size];
+
+        // Only the pool still holds it
+        if (trace.use_count() == 1) {
+            this->cursor = (this->cursor + i + 1) % size;
+            trace->reset(from, to);
+            return trace;
+        }
+    }
+
+    if (size >= MAX_TRACES) {
+        return this->allocate(from, to);
+    }
+
+    Utils::Logger::getInstance().log(Utils::Logger::LOG_WARNING,
+            "Shot trace pool exhausted, growing past %d traces", size);
+    return this->create(from, to);
+}
+
+std::shared_ptr<ShotTrace> TracePool::create(const Math::Vec3& from, const Math::Vec3& to) {
+    auto trace = this->allocate(from, to);
+    this->traces.push_back(trace);
+    return trace;
+}
+
+std::shared_ptr<ShotTrace> TracePool::allocate(const Math::Vec3& from, const Math::Vec3& to) {
+    auto trace = std::allocate_shared<ShotTrace>(Utils::PoolAllocator<ShotTrace>(), from, to);
+    trace->getLine()->setEffect(this->effect);
+    return trace;
+}
+
+}  // namespace Game
+
+}  // namespace PolandBall
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRACEPOOL_H
+#define TRACEPOOL_H
+
+#include "ShotTrace.h"
+#include "RenderEffect.h"
+#include "NonCopyable.h"
+
+#include <Vec3.h>
+#include <memory>
+#include <vector>
+
+namespace PolandBall {
+
+namespace Game {
+
+// Recycled shot traces: a slot is free again once the scene has dropped its destroyed trace
+class TracePool: public Common::NonCopyable {
+public:
+    TracePool() {
+        this->cursor = 0;
+    }
+
+    const std::shared_ptr<Opengl::RenderEffect>& getEffect() const {
+        return this->effect;
+    }
+
+    void setEffect(const std::shared_ptr<Opengl::RenderEffect>& effect) {
+        this->effect = effect;
+    }
+
+    int getSize() const {
+        return this->traces.size();
+    }
+
+    // Makes room for every trace a weapon firing that fast may keep alive at once, up to MAX_TRACES
+    void reserve(float firingSpeed);
+
+    // Drops the traces and the effect, they own GL objects and pooled memory that must go before the context
+    void clear();
+
+    // Past MAX_TRACES busy traces the new one is not pooled and goes away with the scene's copy
+    std::shared_ptr<ShotTrace> acquire(const Math::Vec3& from, const Math::Vec3& to);
+
+private:
+    enum {
+        MAX_TRACES = 256
+    };
+
+    std::shared_ptr<ShotTrace> allocate(const Math::Vec3& from, const Math::Vec3& to);
+    std::shared_ptr<ShotTrace> create(const Math::Vec3& from, const Math::Vec3& to);
+
+    std::vector<std::shared_ptr<ShotTrace>> traces;
+    std::shared_ptr<Opengl::RenderEffect> effect;
+    int cursor;  // Next slot to look at, traces expire roughly in acquisition order
+};
+
+}  // namespace Game
+
+}  // namespace PolandBall
+
+#endif  // TRACEPOOL_H
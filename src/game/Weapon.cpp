@@ -35,6 +35,7 @@ Weapon::Weapon(WeaponSlot slot):
         target(Math::Vec3::UNIT_X) {
     this->targetSlot = slot;
     this->state = WeaponState::STATE_AVAILABLE;
+    this->holstered = false;
 
     this->viewAngle = 0.0f;
     this->bounce = 0.0f;
@@ -45,9 +46,11 @@ Weapon::Weapon(WeaponSlot slot):
     this->firingSpeed = 3.0f;
     this->maxAmmo = 100;
     this->ammo = this->maxAmmo;
+    this->damage = 10;
+    this->owner = HandleTable::NONE;
 
     this->passive = false;
-    this->type = Entity::EntityType::TYPE_WEAPON;
+    this->setType(Entity::EntityType::TYPE_WEAPON);
     sprite->shearX(0.0f, 2);
     sprite->shearY(-0.15f, 1);
 }
@@ -96,19 +99,27 @@ void Weapon::animate(float frameTime) {
     if (this->state == WeaponState::STATE_PICKED) {
         if (this->firing) {
             if (this->relaxTime == 0.0f && this->ammo > 0) {
-                float shotAngle = (rand() / static_cast<float>(RAND_MAX)) * this->groupingAngle;
-                float signCorrection = (rand() % 2 == 0) ? 1.0f : -1.0f;
+                float shotAngle = this->scene->getRandom() * this->groupingAngle;
+                float signCorrection = (this->scene->getRandom() < 0.5f) ? 1.0f : -1.0f;
 
                 Math::Vec3 position(this->getPosition());
-                Math::Vec3 shotTarget(this->target);
-                shotTarget.normalize();
-                shotTarget *= 10.0f;
+                Math::Vec3 direction(this->target);
+                direction.normalize();
 
                 Math::Quaternion q(Math::Vec3::UNIT_Z, shotAngle * signCorrection * M_PI / 180.0f);
-                shotTarget = q.extractMat4().extractMat3() * shotTarget;
-
-                auto parent = std::shared_ptr<Scene>(this->scene);
-                parent->addEntity(EntityFactory::getInstance().createTrace(position, position + shotTarget));
+                direction = q.extractMat4().extractMat3() * direction;
+
+                // Shots stop at the first block or player on their way
+                Scene::RayHit hit;
+                if (this->scene->raycast(position, direction, RANGE,
+                        Entity::CollisionLayer::LAYER_GENERIC | Entity::CollisionLayer::LAYER_PLAYER,
+                        hit, this->scene->getEntity(this->owner))) {
+                    if (hit.entity->getType() == Entity::EntityType::TYPE_PLAYER) {
+                        static_cast<Player*>(hit.entity)->applyDamage(this->damage);
+                    }
+                }
+
+                this->scene->addEntity(EntityFactory::getInstance().createTrace(position, hit.point));
                 this->ammo--;
             }
 
@@ -78,6 +78,23 @@ public:
         return this->firingSpeed;
     }
 
+    void setDamage(int damage) {
+        this->damage = damage;
+    }
+
+    int getDamage() const {
+        return this->damage;
+    }
+
+    // Player holding the weapon, never hit by its own shots
+    void setOwner(EntityHandle owner) {
+        this->owner = owner;
+    }
+
+    EntityHandle getOwner() const {
+        return this->owner;
+    }
+
     void setAmmo(int ammo) {
         this->ammo = ammo;
     }
@@ -102,6 +119,15 @@ public:
         return this->state;
     }
 
+    // Picked but not in the active slot, skipped by Scene::render
+    void setHolstered(bool holstered) {
+        this->holstered = holstered;
+    }
+
+    bool isHolstered() const {
+        return this->holstered;
+    }
+
     void fire() {
         this->firing = true;
     }
@@ -109,6 +135,10 @@ public:
     void aimAt(const Math::Vec3& target);
 
 private:
+    enum {
+        RANGE = 10  // Farthest a shot reaches
+    };
+
     void onCollision(const std::shared_ptr<Entity>& another, Collider::CollideSide side) {
         if (this->state == WeaponState::STATE_THROWN) {
             if (side == Collider::CollideSide::SIDE_BOTTOM && another->isCollidable()) {
@@ -127,9 +157,12 @@ private:
     float firingSpeed;  // Shots per second
     int maxAmmo;
     int ammo;
+    int damage;  // Per hit
+    EntityHandle owner;
 
     WeaponSlot targetSlot;
     WeaponState state;
+    bool holstered;
     float viewAngle;
     float bounce;
     float relaxTime;
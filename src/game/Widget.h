@@ -35,7 +35,7 @@ class Widget: public SpriteEntity {
 public:
     Widget() {
         this->collidable = false;
-        this->type = Entity::EntityType::TYPE_WIDGET;
+        this->setType(Entity::EntityType::TYPE_WIDGET);
     }
 
     virtual ~Widget() {}
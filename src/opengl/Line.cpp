@@ -50,6 +50,20 @@ void Line::initialize() {
     this->load(data);
 }
 
+void Line::update() {
+    if (this->vao == 0) {
+        return;
+    }
+
+    GLfloat vertexData[6];
+    memcpy(vertexData, this->from.data(), sizeof(float) * 3);
+    memcpy(vertexData + 3, this->to.data(), sizeof(float) * 3);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->buffers[VERTEX_BUFFER]);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertexData), vertexData);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 }  // namespace Opengl
 
 }  // namespace PolandBall
@@ -54,7 +54,7 @@ public:
 
     void setFrom(const Math::Vec3& from) {
         this->from = from;
-        this->initialize();
+        this->update();
     }
 
     const Math::Vec3& getTo() const {
@@ -63,11 +63,19 @@ public:
 
     void setTo(const Math::Vec3& to) {
         this->to = to;
-        this->initialize();
+        this->update();
+    }
+
+    // Moves both ends with a single upload
+    void setEnds(const Math::Vec3& from, const Math::Vec3& to) {
+        this->from = from;
+        this->to = to;
+        this->update();
     }
 
 private:
     void initialize();
+    void update();  // Rewrites the vertex buffer in place, no reallocation
 
     void beforeRender() {
         this->effect->enable();
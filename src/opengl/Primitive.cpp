@@ -37,23 +37,34 @@ void Primitive::rotate(const Math::Vec3& vector, float angle) {
     Math::Quaternion q(axis.normalize(), angle * M_PI / 180.0f);
     q.normalize();
 
-    this->rotation = q.extractMat4();
-
     float xAngleNew, yAngleNew, zAngleNew;
     q.extractEulerAngles(xAngleNew, yAngleNew, zAngleNew);
 
-    this->xAngle = xAngleNew * 180.f / M_PI;
-    this->yAngle = yAngleNew * 180.f / M_PI;
-    this->zAngle = zAngleNew * 180.f / M_PI;
+    xAngleNew *= 180.f / M_PI;
+    yAngleNew *= 180.f / M_PI;
+    zAngleNew *= 180.f / M_PI;
+
+    // Same orientation again, keep the cached model matrix
+    if (xAngleNew == this->xAngle && yAngleNew == this->yAngle && zAngleNew == this->zAngle) {
+        return;
+    }
+
+    this->rotation = q.extractMat4();
+    this->modelDirty = true;
+
+    this->xAngle = xAngleNew;
+    this->yAngle = yAngleNew;
+    this->zAngle = zAngleNew;
 }
 
 void Primitive::render() {
-    if (this->effect == nullptr) {
+    if (this->effect == nullptr || this->vao == 0) {
         return;
     }
 
     this->effect->enable();
-    this->effect->setUniform("lw", this->translation * this->rotation * this->scaling);
+    const Math::Mat4& model = this->getModel();
+    this->effect->setUniform("lw", model, this->modelVersion);
     this->beforeRender();
 
     glBindVertexArray(this->vao);
@@ -65,6 +76,18 @@ void Primitive::render() {
 }
 
 void Primitive::load(const PrimitiveData& data) {
+    this->renderMode = data.renderMode;
+    this->vertexCount = data.indexDataSize / sizeof(GLuint);
+
+    if (!Context::isAvailable()) {
+        return;
+    }
+
+    if (this->buffers[VERTEX_BUFFER] == 0) {
+        glGenBuffers(2, this->buffers);
+        glGenVertexArrays(1, &this->vao);
+    }
+
     glBindVertexArray(this->vao);
 
     glBindBuffer(GL_ARRAY_BUFFER, this->buffers[VERTEX_BUFFER]);
@@ -80,9 +103,6 @@ void Primitive::load(const PrimitiveData& data) {
     }
 
     glBindVertexArray(0);
-
-    this->renderMode = data.renderMode;
-    this->vertexCount = data.indexDataSize / sizeof(GLuint);
 }
 
 }  // namespace Opengl
@@ -28,6 +28,7 @@
 #include "Rotatable.h"
 #include "NonCopyable.h"
 #include "RenderEffect.h"
+#include "Context.h"
 
 #include <GL/glew.h>
 #include <Vec3.h>
@@ -49,9 +50,12 @@ public:
 
         this->renderMode = GL_TRIANGLES;
         this->vertexCount = 0;
+        this->modelVersion = 0;
+        this->modelDirty = true;
 
-        glGenBuffers(2, this->buffers);
-        glGenVertexArrays(1, &this->vao);
+        this->buffers[VERTEX_BUFFER] = 0;
+        this->buffers[ELEMENT_BUFFER] = 0;
+        this->vao = 0;
     }
 
     Primitive(float x, float y, float z):
@@ -65,16 +69,24 @@ public:
     }
 
     virtual ~Primitive() {
-        glDeleteVertexArrays(1, &this->vao);
-        glDeleteBuffers(2, this->buffers);
+        // Shared geometry has no buffers of its own and is released by its owner
+        if (this->buffers[VERTEX_BUFFER] != 0) {
+            glDeleteVertexArrays(1, &this->vao);
+            glDeleteBuffers(2, this->buffers);
+        }
     }
 
     using Movable::setPosition;
 
     void setPosition(const Math::Vec3& position) {
-        this->translation.set(0, 3, position.get(Math::Vec3::X));
-        this->translation.set(1, 3, position.get(Math::Vec3::Y));
-        this->translation.set(2, 3, position.get(Math::Vec3::Z));
+        if (this->translation.get(0, 3) != position.get(Math::Vec3::X) ||
+                this->translation.get(1, 3) != position.get(Math::Vec3::Y) ||
+                this->translation.get(2, 3) != position.get(Math::Vec3::Z)) {
+            this->translation.set(0, 3, position.get(Math::Vec3::X));
+            this->translation.set(1, 3, position.get(Math::Vec3::Y));
+            this->translation.set(2, 3, position.get(Math::Vec3::Z));
+            this->modelDirty = true;
+        }
     }
 
     Math::Vec3 getPosition() const {
@@ -98,15 +110,24 @@ public:
     void rotate(const Math::Vec3& vector, float angle);
 
     void scaleX(float factor) {
-        this->scaling.set(0, 0, this->scaling.get(0, 0) * factor);
+        if (factor != 1.0f) {
+            this->scaling.set(0, 0, this->scaling.get(0, 0) * factor);
+            this->modelDirty = true;
+        }
     }
 
     void scaleY(float factor) {
-        this->scaling.set(1, 1, this->scaling.get(1, 1) * factor);
+        if (factor != 1.0f) {
+            this->scaling.set(1, 1, this->scaling.get(1, 1) * factor);
+            this->modelDirty = true;
+        }
     }
 
     void scaleZ(float factor) {
-        this->scaling.set(2, 2, this->scaling.get(2, 2) * factor);
+        if (factor != 1.0f) {
+            this->scaling.set(2, 2, this->scaling.get(2, 2) * factor);
+            this->modelDirty = true;
+        }
     }
 
     float getXFactor() const {
@@ -125,10 +146,21 @@ public:
         return this->effect;
     }
 
-    void setEffect(std::shared_ptr<RenderEffect>& effect) {
+    void setEffect(const std::shared_ptr<RenderEffect>& effect) {
         this->effect = effect;
     }
 
+    // translation * rotation * scaling, composed again only after one of them changed
+    const Math::Mat4& getModel() {
+        if (this->modelDirty) {
+            this->model = this->translation * this->rotation * this->scaling;
+            this->modelVersion = nextVersion();
+            this->modelDirty = false;
+        }
+
+        return this->model;
+    }
+
     void render();
 
 protected:
@@ -156,20 +188,37 @@ protected:
 
     virtual void beforeRender() {}
     virtual void afterRender() {}
-    void load(const PrimitiveData& data);
+    void load(const PrimitiveData& data);  // Uploads to buffers of this primitive alone
+
+    // Draws geometry owned elsewhere, no GL objects are created
+    void share(GLuint vao, GLsizei vertexCount, GLenum renderMode) {
+        this->vao = vao;
+        this->vertexCount = vertexCount;
+        this->renderMode = renderMode;
+    }
+
+    // Unique across primitives, RenderEffect skips uploads of a version it already holds.
+    // Versions are taken while rendering, on the GL thread only.
+    static unsigned long long nextVersion() {
+        static unsigned long long version = 0;
+        return ++version;
+    }
 
     std::shared_ptr<RenderEffect> effect;
 
     Math::Mat4 translation;
     Math::Mat4 rotation;
     Math::Mat4 scaling;
+    Math::Mat4 model;
+    unsigned long long modelVersion;  // Of the model matrix, 0 before the first composition
+    bool modelDirty;
 
     float xAngle;
     float yAngle;
     float zAngle;
 
     GLuint buffers[2];
-    GLuint vao;
+    GLuint vao;  // 0 without a GL context
 
     GLenum renderMode;
     GLsizei vertexCount;
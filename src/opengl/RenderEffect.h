@@ -64,6 +64,19 @@ public:
         }
     }
 
+    // Skips the upload when the uniform already holds this version of the matrix
+    void setUniform(const std::string& name, const Math::Mat4& value, unsigned long long version) {
+        Uniform& uniform = this->lookupUniform(name);
+        if (version != 0 && uniform.version == version) {
+            return;
+        }
+
+        uniform.version = version;
+        if (uniform.location > -1) {
+            glUniformMatrix4fv(uniform.location, 1, GL_TRUE, (GLfloat*)value.data());
+        }
+    }
+
     void setUniform(const std::string& name, const Math::Mat3& value) {
         GLint uniform = this->checkoutUniform(name);
         if (uniform > -1) {
@@ -78,6 +91,18 @@ public:
         }
     }
 
+    void setUniform(const std::string& name, const Math::Vec4& value, unsigned long long version) {
+        Uniform& uniform = this->lookupUniform(name);
+        if (version != 0 && uniform.version == version) {
+            return;
+        }
+
+        uniform.version = version;
+        if (uniform.location > -1) {
+            glUniform4fv(uniform.location, 1, (GLfloat*)value.data());
+        }
+    }
+
     void setUniform(const std::string& name, const Math::Vec3& value) {
         GLint uniform = this->checkoutUniform(name);
         if (uniform > -1) {
@@ -118,17 +143,31 @@ public:
     }
 
 private:
-    GLint checkoutUniform(const std::string& name) {
+    typedef struct {
+        GLint location;
+        unsigned long long version;  // Of the last versioned upload, 0 if unknown
+    } Uniform;
+
+    Uniform& lookupUniform(const std::string& name) {
         this->enable();
 
-        if (this->uniforms.find(name) == this->uniforms.end()) {
-            this->uniforms.insert(std::make_pair(name, glGetUniformLocation(this->program, name.c_str())));
+        auto uniform = this->uniforms.find(name);
+        if (uniform == this->uniforms.end()) {
+            Uniform newUniform = { glGetUniformLocation(this->program, name.c_str()), 0 };
+            uniform = this->uniforms.insert(std::make_pair(name, newUniform)).first;
         }
 
-        return this->uniforms.at(name);
+        return uniform->second;
+    }
+
+    GLint checkoutUniform(const std::string& name) {
+        Uniform& uniform = this->lookupUniform(name);
+        uniform.version = 0;
+
+        return uniform.location;
     }
 
-    std::unordered_map<std::string, GLint> uniforms;
+    std::unordered_map<std::string, Uniform> uniforms;
     std::vector<GLuint> shaderList;
 
     GLuint program;
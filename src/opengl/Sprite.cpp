@@ -44,25 +44,49 @@ const GLuint Sprite::indices[] = {
     0, 2, 3,
 };
 
-Sprite::Sprite() {
-    PrimitiveData data;
+Sprite::Sprite():
+        region(0.0f, 0.0f, 1.0f, 1.0f) {
+    this->uvTransformVersion = 0;
+    this->uvTransformDirty = true;
 
-    data.vertexDataSize = sizeof(Sprite::vertices);
-    data.vertexData = std::unique_ptr<GLfloat[]>(new GLfloat[data.vertexDataSize / sizeof(GLfloat)]);
-    memcpy(data.vertexData.get(), Sprite::vertices, data.vertexDataSize);
+    this->share(getQuad().vao, sizeof(Sprite::indices) / sizeof(GLuint), GL_TRIANGLES);
+}
+
+bool Sprite::createQuad() {
+    Quad& quad = getQuad();
+    if (quad.vao != 0) {
+        return true;
+    }
+
+    if (!Context::isAvailable()) {
+        return false;
+    }
 
-    data.indexDataSize = sizeof(Sprite::indices);
-    data.indexData = std::unique_ptr<GLuint[]>(new GLuint[data.indexDataSize / sizeof(GLuint)]);
-    memcpy(data.indexData.get(), Sprite::indices, data.indexDataSize);
+    glGenBuffers(2, quad.buffers);
+    glGenVertexArrays(1, &quad.vao);
+    glBindVertexArray(quad.vao);
 
-    PrimitiveData::VertexAttribute coordinate = { 3, GL_FLOAT, 0 };
-    PrimitiveData::VertexAttribute uv = { 2, GL_FLOAT, sizeof(float) * 12 };
+    glBindBuffer(GL_ARRAY_BUFFER, quad.buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Sprite::vertices), Sprite::vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad.buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Sprite::indices), Sprite::indices, GL_STATIC_DRAW);
 
-    data.vertexAttributes.push_back(coordinate);
-    data.vertexAttributes.push_back(uv);
-    data.renderMode = GL_TRIANGLES;
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(GLfloat) * 12));
+
+    glBindVertexArray(0);
+    return true;
+}
 
-    this->load(data);
+void Sprite::destroyQuad() {
+    Quad& quad = getQuad();
+    if (quad.vao != 0) {
+        glDeleteVertexArrays(1, &quad.vao);
+        glDeleteBuffers(2, quad.buffers);
+        quad.vao = 0;
+    }
 }
 
 }  // namespace Opengl
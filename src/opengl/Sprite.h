@@ -29,6 +29,7 @@
 
 #include <GL/glew.h>
 #include <Mat4.h>
+#include <Vec4.h>
 #include <string>
 #include <memory>
 
@@ -40,16 +41,29 @@ class Sprite: public Primitive, public Common::Transformable {
 public:
     Sprite();
 
+    // The quad every sprite draws, needs a context and must exist before sprites are built
+    static bool createQuad();
+    static void destroyQuad();
+
     void replicateX(float factor) {
-        this->replication.set(0, 0, factor);
+        if (this->replication.get(0, 0) != factor) {
+            this->replication.set(0, 0, factor);
+            this->uvTransformDirty = true;
+        }
     }
 
     void replicateY(float factor) {
-        this->replication.set(1, 1, factor);
+        if (this->replication.get(1, 1) != factor) {
+            this->replication.set(1, 1, factor);
+            this->uvTransformDirty = true;
+        }
     }
 
     void replicateZ(float factor) {
-        this->replication.set(2, 2, factor);
+        if (this->replication.get(2, 2) != factor) {
+            this->replication.set(2, 2, factor);
+            this->uvTransformDirty = true;
+        }
     }
 
     float getXReplicaFactor() const {
@@ -66,22 +80,40 @@ public:
 
     void shearX(float slice, int totalSlices) {
         if (slice < totalSlices) {
-            this->shear.set(0, 0, 1.0f / totalSlices);
-            this->shear.set(0, 3, slice / totalSlices);
+            float scale = 1.0f / totalSlices;
+            float offset = slice / totalSlices;
+
+            if (this->shear.get(0, 0) != scale || this->shear.get(0, 3) != offset) {
+                this->shear.set(0, 0, scale);
+                this->shear.set(0, 3, offset);
+                this->uvTransformDirty = true;
+            }
         }
     }
 
     void shearY(float slice, int totalSlices) {
         if (slice < totalSlices) {
-            this->shear.set(1, 1, 1.0f / totalSlices);
-            this->shear.set(1, 3, slice / totalSlices);
+            float scale = 1.0f / totalSlices;
+            float offset = slice / totalSlices;
+
+            if (this->shear.get(1, 1) != scale || this->shear.get(1, 3) != offset) {
+                this->shear.set(1, 1, scale);
+                this->shear.set(1, 3, offset);
+                this->uvTransformDirty = true;
+            }
         }
     }
 
     void shearZ(float slice, int totalSlices) {
         if (slice < totalSlices) {
-            this->shear.set(2, 2, 1.0f / totalSlices);
-            this->shear.set(2, 3, slice / totalSlices);
+            float scale = 1.0f / totalSlices;
+            float offset = slice / totalSlices;
+
+            if (this->shear.get(2, 2) != scale || this->shear.get(2, 3) != offset) {
+                this->shear.set(2, 2, scale);
+                this->shear.set(2, 3, offset);
+                this->uvTransformDirty = true;
+            }
         }
     }
 
@@ -100,23 +132,49 @@ public:
         slice = this->shear.get(2, 3) / this->shear.get(2, 2);
     }
 
+    // UV offset in xy and size in zw of the texture part drawn, replication and shear wrap inside it
+    const Math::Vec4& getRegion() const {
+        return this->region;
+    }
+
+    void setRegion(const Math::Vec4& region) {
+        if (this->region != region) {
+            this->region = region;
+            this->uvTransformDirty = true;
+        }
+    }
+
+    // replication * shear, composed again only after one of them changed
+    const Math::Mat4& getUvTransform() {
+        if (this->uvTransformDirty) {
+            this->uvTransform = this->replication * this->shear;
+            this->uvTransformVersion = nextVersion();
+            this->uvTransformDirty = false;
+        }
+
+        return this->uvTransform;
+    }
+
     std::shared_ptr<Texture>& getTexture() {
         return this->texture;
     }
 
-    void setTexture(std::shared_ptr<Texture>& texture) {
+    void setTexture(const std::shared_ptr<Texture>& texture) {
         this->texture = texture;
     }
 
 private:
+    friend class SpriteBatch;  // Draws the quad too
+
     void beforeRender() {
         if (this->texture == nullptr) {
             return;
         }
 
+        const Math::Mat4& uvTransform = this->getUvTransform();
         this->texture->bind();
-        this->effect->enable();
-        this->effect->setUniform("transform", this->replication * this->shear);
+        this->effect->setUniform("transform", uvTransform, this->uvTransformVersion);
+        this->effect->setUniform("region", this->region, this->uvTransformVersion);
     }
 
     void afterRender() {
@@ -131,9 +189,23 @@ private:
 
     Math::Mat4 replication;
     Math::Mat4 shear;
+    Math::Mat4 uvTransform;
+    Math::Vec4 region;
+    unsigned long long uvTransformVersion;
+    bool uvTransformDirty;
+
+    typedef struct {
+        GLuint vao;
+        GLuint buffers[2];  // Vertices and indices
+    } Quad;
+
+    static Quad& getQuad() {
+        static Quad quad = { 0, { 0, 0 } };
+        return quad;
+    }
 
-    static const GLfloat vertices[];
-    static const GLuint indices[];
+    static const GLfloat vertices[20];  // 4 coords, then 4 UVs
+    static const GLuint indices[6];
 };
 
 }  // namespace Opengl
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "SpriteBatch.h"
+
+namespace PolandBall {
+
+namespace Opengl {
+
+SpriteBatch::SpriteBatch() {
+    this->usedGroups = 0;
+    this->indexCount = sizeof(Sprite::indices) / sizeof(GLuint);
+
+    this->instanceBuffer = 0;
+    this->vao = 0;
+
+    const Sprite::Quad& quad = Sprite::getQuad();
+    if (quad.vao == 0) {
+        return;  // No context or Sprite::createQuad() not called yet
+    }
+
+    // A VAO of its own for the instance attributes, the quad buffers are shared with every sprite
+    glGenBuffers(1, &this->instanceBuffer);
+    glGenVertexArrays(1, &this->vao);
+    glBindVertexArray(this->vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quad.buffers[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad.buffers[1]);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(GLfloat) * 12));
+
+    // Pointers into the instance buffer are set per group in flush()
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+    for (int i = 0; i < INSTANCE_ATTRIBUTES; i++) {
+        glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + i);
+        glVertexAttribDivisor(INSTANCE_ATTRIBUTE + i, 1);
+    }
+
+    glBindVertexArray(0);
+}
+
+SpriteBatch::~SpriteBatch() {
+    if (this->vao != 0) {
+        glDeleteVertexArrays(1, &this->vao);
+        glDeleteBuffers(1, &this->instanceBuffer);
+    }
+}
+
+void SpriteBatch::add(Sprite* sprite) {
+    Texture* texture = sprite->getTexture().get();
+
+    auto groupIndex = this->groupIndexes.find(texture);
+    if (groupIndex == this->groupIndexes.end()) {
+        if (this->usedGroups == static_cast<int>(this->groups.size())) {
+            this->groups.push_back(Group());
+        }
+
+        this->groups[this->usedGroups].texture = texture;
+        groupIndex = this->groupIndexes.insert(std::make_pair(texture, this->usedGroups++)).first;
+    }
+
+    std::vector<GLfloat>& instances = this->groups[groupIndex->second].instances;
+    const Math::Mat4& model = sprite->getModel();
+    const Math::Mat4& uvTransform = sprite->getUvTransform();
+
+    // Rows, the shader transposes them back like RenderEffect::setUniform() does
+    const GLfloat* data = (const GLfloat*)model.data();
+    instances.insert(instances.end(), data, data + 16);
+
+    instances.push_back(uvTransform.get(0, 0));
+    instances.push_back(uvTransform.get(1, 1));
+    instances.push_back(uvTransform.get(0, 3));
+    instances.push_back(uvTransform.get(1, 3));
+
+    const GLfloat* region = (const GLfloat*)sprite->getRegion().data();
+    instances.insert(instances.end(), region, region + 4);
+}
+
+int SpriteBatch::flush() {
+    if (this->usedGroups == 0) {
+        return 0;
+    }
+
+    int drawCalls = 0;
+    if (this->effect != nullptr && this->vao != 0) {
+        size_t totalSize = 0;
+        for (int i = 0; i < this->usedGroups; i++) {
+            totalSize += this->groups[i].instances.size() * sizeof(GLfloat);
+        }
+
+        this->effect->enable();
+        glBindVertexArray(this->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);  // Orphan last frame's instances
+
+        size_t offset = 0;
+        for (int i = 0; i < this->usedGroups; i++) {
+            Group& group = this->groups[i];
+            size_t size = group.instances.size() * sizeof(GLfloat);
+            glBufferSubData(GL_ARRAY_BUFFER, offset, size, group.instances.data());
+
+            for (int j = 0; j < INSTANCE_ATTRIBUTES; j++) {
+                glVertexAttribPointer(INSTANCE_ATTRIBUTE + j, 4, GL_FLOAT, GL_FALSE,
+                        INSTANCE_SIZE * sizeof(GLfloat), (GLvoid*)(offset + j * 4 * sizeof(GLfloat)));
+            }
+
+            if (group.texture != nullptr) {
+                group.texture->bind();
+            }
+
+            glDrawElementsInstanced(GL_TRIANGLES, this->indexCount, GL_UNSIGNED_INT, (GLvoid*)0,
+                    group.instances.size() / INSTANCE_SIZE);
+            drawCalls++;
+            offset += size;
+        }
+
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        this->effect->disable();
+    }
+
+    for (int i = 0; i < this->usedGroups; i++) {
+        this->groups[i].instances.clear();
+    }
+
+    this->groupIndexes.clear();
+    this->usedGroups = 0;
+
+    return drawCalls;
+}
+
+}  // namespace Opengl
+
+}  // namespace PolandBall
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include "Sprite.h"
+#include "Texture.h"
+#include "RenderEffect.h"
+#include "NonCopyable.h"
+
+#include <GL/glew.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace PolandBall {
+
+namespace Opengl {
+
+// Draws queued sprites with one instanced call per texture
+class SpriteBatch: public Common::NonCopyable {
+public:
+    SpriteBatch();
+    ~SpriteBatch();
+
+    const std::shared_ptr<RenderEffect>& getEffect() const {
+        return this->effect;
+    }
+
+    // Instanced counterpart of the sprite effect, see shaders/batch.shader
+    void setEffect(const std::shared_ptr<RenderEffect>& effect) {
+        this->effect = effect;
+    }
+
+    // Takes the current model, UV transform and region, the texture must outlive the next flush()
+    void add(Sprite* sprite);
+
+    // Draws and forgets queued sprites in the order their textures were first queued, returns draw calls made
+    int flush();
+
+private:
+    enum {
+        INSTANCE_ATTRIBUTE = 2,  // Model matrix rows take 2 to 5, UV scale and offset 6, region 7
+        INSTANCE_ATTRIBUTES = 6,
+        INSTANCE_SIZE = 24       // Floats per instance
+    };
+
+    typedef struct {
+        Texture* texture;
+        std::vector<GLfloat> instances;
+    } Group;
+
+    std::shared_ptr<RenderEffect> effect;
+    std::vector<Group> groups;  // Only the first usedGroups are queued, the rest keep their storage
+    std::unordered_map<Texture*, int> groupIndexes;
+    int usedGroups;
+
+    GLuint instanceBuffer;
+    GLuint vao;
+    GLsizei indexCount;
+};
+
+}  // namespace Opengl
+
+}  // namespace PolandBall
+
+#endif  // SPRITEBATCH_H
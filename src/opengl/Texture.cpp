@@ -26,12 +26,12 @@ namespace PolandBall {
 
 namespace Opengl {
 
-bool Texture::load(SDL_Surface* image) {
-    if (image == nullptr) {
+bool Texture::load(SDL_Surface* image, int maxMipmapLevel) {
+    if (image == nullptr || this->texture == 0) {
         return false;
     }
 
-    SDL_Surface* source = (image->format->BytesPerPixel != 4) ? this->convertToRGBA(image) : image;
+    SDL_Surface* source = (image->format->BytesPerPixel != 4) ? Texture::convertToRGBA(image) : image;
     if (source == nullptr) {
         return false;
     }
@@ -43,6 +43,7 @@ bool Texture::load(SDL_Surface* image) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxMipmapLevel);
     glGenerateMipmap(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -60,6 +61,7 @@ SDL_Surface* Texture::convertToRGBA(SDL_Surface* image) {
         return nullptr;
     }
 
+    SDL_SetSurfaceBlendMode(image, SDL_BLENDMODE_NONE);  // Copy alpha as is instead of blending over black
     if (SDL_BlitSurface(image, nullptr, newSource, nullptr)) {
         SDL_FreeSurface(newSource);
         return nullptr;
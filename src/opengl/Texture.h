@@ -24,6 +24,7 @@
 #define TEXTURE_H
 
 #include "NonCopyable.h"
+#include "Context.h"
 
 #include <GL/glew.h>
 #include <SDL2/SDL_image.h>
@@ -36,18 +37,27 @@ namespace Opengl {
 class Texture: public Common::NonCopyable {
 public:
     Texture() {
-        glGenTextures(1, &this->texture);
+        this->texture = 0;
+        if (Context::isAvailable()) {
+            glGenTextures(1, &this->texture);
+        }
     }
 
     ~Texture() {
-        glDeleteTextures(1, &this->texture);
+        if (this->texture != 0) {
+            glDeleteTextures(1, &this->texture);
+        }
     }
 
     GLuint getTextureHandle() const {
         return this->texture;
     }
 
-    bool load(SDL_Surface* image);
+    // Levels past maxMipmapLevel are not sampled, 1000 is the GL default
+    bool load(SDL_Surface* image, int maxMipmapLevel = 1000);
+
+    // Copy of the image with RGBA bytes in memory, nullptr on failure
+    static SDL_Surface* convertToRGBA(SDL_Surface* image);
 
     void bind() {
         glActiveTexture(GL_TEXTURE0);
@@ -60,8 +70,6 @@ public:
     }
 
 private:
-    SDL_Surface* convertToRGBA(SDL_Surface* image);
-
     GLuint texture;
 };
 
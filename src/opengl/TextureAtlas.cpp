@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PolandBall {
+
+namespace Opengl {
+
+bool TextureAtlas::add(const std::string& name, SDL_Surface* image) {
+    if (image == nullptr || image->w + 2 * PADDING > PAGE_SIZE || image->h + 2 * PADDING > PAGE_SIZE) {
+        return false;
+    }
+
+    SDL_Surface* surface = Texture::convertToRGBA(image);
+    if (surface == nullptr) {
+        return false;
+    }
+
+    Image entry = { name, surface, 0, 0, -1 };
+    this->images.push_back(entry);
+    return true;
+}
+
+bool TextureAtlas::build() {
+    // Tallest first keeps the skyline flat
+    std::vector<Image*> order;
+    for (auto& image: this->images) {
+        order.push_back(&image);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [](const Image* image, const Image* another) {
+        return image->surface->h > another->surface->h;
+    });
+
+    std::vector<std::vector<SkylineNode>> skylines;
+    std::vector<std::pair<int, int>> extents;  // Used width and height of every page
+    for (auto image: order) {
+        int width = alignUp(image->surface->w + 2 * PADDING);
+        int height = alignUp(image->surface->h + 2 * PADDING);
+
+        image->page = -1;
+        for (int i = 0; i < static_cast<int>(skylines.size()); i++) {
+            if (this->place(skylines[i], width, height, image->x, image->y)) {
+                image->page = i;
+                break;
+            }
+        }
+
+        if (image->page == -1) {
+            SkylineNode node = { 0, 0, PAGE_SIZE };
+            skylines.push_back(std::vector<SkylineNode>(1, node));
+            extents.push_back(std::make_pair(0, 0));
+            image->page = skylines.size() - 1;
+            this->place(skylines.back(), width, height, image->x, image->y);
+        }
+
+        auto& extent = extents[image->page];
+        extent.first = std::max(extent.first, image->x + width);
+        extent.second = std::max(extent.second, image->y + height);
+    }
+
+    int firstPage = this->pages.size();
+    for (auto& extent: extents) {
+        // Power of two pages, no larger than what their images use
+        int width = 1 << MAX_MIPMAP_LEVEL;
+        while (width < extent.first) {
+            width <<= 1;
+        }
+
+        int height = 1 << MAX_MIPMAP_LEVEL;
+        while (height < extent.second) {
+            height <<= 1;
+        }
+
+        extent = std::make_pair(width, height);
+    }
+
+    for (int i = 0; i < static_cast<int>(extents.size()); i++) {
+        SDL_Surface* page = SDL_CreateRGBSurface(SDL_SWSURFACE, extents[i].first, extents[i].second, 32,
+                0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+        if (page == nullptr) {
+            return false;
+        }
+
+        SDL_FillRect(page, nullptr, 0);
+        for (auto& image: this->images) {
+            if (image.page == i) {
+                this->blit(image, page);
+            }
+        }
+
+        std::shared_ptr<Texture> texture(new Texture());
+        texture->load(page, MAX_MIPMAP_LEVEL);
+        this->pages.push_back(texture);
+
+        SDL_FreeSurface(page);
+    }
+
+    for (auto& image: this->images) {
+        float width = extents[image.page].first;
+        float height = extents[image.page].second;
+
+        Entry entry;
+        entry.name = image.name;
+        entry.page = firstPage + image.page;
+        entry.region = Math::Vec4((image.x + PADDING) / width, (image.y + PADDING) / height,
+                image.surface->w / width, image.surface->h / height);
+        this->entries.push_back(entry);
+
+        SDL_FreeSurface(image.surface);
+    }
+
+    this->images.clear();
+    return true;
+}
+
+int TextureAtlas::fit(const std::vector<SkylineNode>& skyline, int index, int width, int height) const {
+    if (skyline[index].x + width > PAGE_SIZE) {
+        return -1;
+    }
+
+    // The rectangle rests on the highest node it spans
+    int y = 0;
+    for (int i = index, remaining = width; remaining > 0; i++) {
+        y = std::max(y, skyline[i].y);
+        if (y + height > PAGE_SIZE) {
+            return -1;
+        }
+
+        remaining -= skyline[i].width;
+    }
+
+    return y;
+}
+
+bool TextureAtlas::place(std::vector<SkylineNode>& skyline, int width, int height, int& x, int& y) const {
+    int bestIndex = -1;
+    int bestTop = PAGE_SIZE + 1;
+    int bestWidth = PAGE_SIZE + 1;
+
+    for (int i = 0; i < static_cast<int>(skyline.size()); i++) {
+        int nodeY = this->fit(skyline, i, width, height);
+        if (nodeY == -1) {
+            continue;
+        }
+
+        if (nodeY + height < bestTop || (nodeY + height == bestTop && skyline[i].width < bestWidth)) {
+            bestIndex = i;
+            bestTop = nodeY + height;
+            bestWidth = skyline[i].width;
+        }
+    }
+
+    if (bestIndex == -1) {
+        return false;
+    }
+
+    x = skyline[bestIndex].x;
+    y = bestTop - height;
+
+    SkylineNode node = { x, bestTop, width };
+    skyline.insert(skyline.begin() + bestIndex, node);
+
+    // Cut the nodes the new one now shadows
+    for (int i = bestIndex + 1; i < static_cast<int>(skyline.size()); ) {
+        int overlap = node.x + node.width - skyline[i].x;
+        if (overlap <= 0) {
+            break;
+        }
+
+        skyline[i].x += overlap;
+        skyline[i].width -= overlap;
+        if (skyline[i].width > 0) {
+            break;
+        }
+
+        skyline.erase(skyline.begin() + i);
+    }
+
+    for (int i = 0; i + 1 < static_cast<int>(skyline.size()); ) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+
+    return true;
+}
+
+void TextureAtlas::blit(const Image& image, SDL_Surface* page) const {
+    const SDL_Surface* source = image.surface;
+
+    // Edge pixels are repeated over the padding so filtering never reaches a neighbour
+    for (int row = -PADDING; row < source->h + PADDING; row++) {
+        int sourceRow = std::min(std::max(row, 0), source->h - 1);
+        const Uint32* from = (const Uint32*)((const Uint8*)source->pixels + sourceRow * source->pitch);
+        Uint32* to = (Uint32*)((Uint8*)page->pixels + (image.y + PADDING + row) * page->pitch) +
+                image.x + PADDING;
+
+        memcpy(to, from, source->w * sizeof(Uint32));
+        for (int column = 1; column <= PADDING; column++) {
+            to[-column] = from[0];
+            to[source->w - 1 + column] = from[source->w - 1];
+        }
+    }
+}
+
+}  // namespace Opengl
+
+}  // namespace PolandBall
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include "Texture.h"
+#include "NonCopyable.h"
+
+#include <SDL2/SDL.h>
+#include <Vec4.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PolandBall {
+
+namespace Opengl {
+
+// Packs images into a few large textures along a skyline, bottom left first
+class TextureAtlas: public Common::NonCopyable {
+public:
+    typedef struct {
+        std::string name;
+        int page;            // Index into getPages()
+        Math::Vec4 region;   // UV offset in xy, size in zw
+    } Entry;
+
+    TextureAtlas() {}
+
+    ~TextureAtlas() {
+        for (auto& image: this->images) {
+            SDL_FreeSurface(image.surface);
+        }
+    }
+
+    // Keeps an RGBA copy of the image until build(), false if it can never fit a page
+    bool add(const std::string& name, SDL_Surface* image);
+
+    // Places and uploads everything added so far
+    bool build();
+
+    const std::vector<std::shared_ptr<Texture>>& getPages() const {
+        return this->pages;
+    }
+
+    const std::vector<Entry>& getEntries() const {
+        return this->entries;
+    }
+
+private:
+    enum {
+        PAGE_SIZE = 2048,
+        PADDING = 4,         // Border pixels extruded around every image
+        MAX_MIPMAP_LEVEL = 2 // Texels of deeper levels would mix neighbours through the padding
+    };
+
+    typedef struct {
+        std::string name;
+        SDL_Surface* surface;
+        int x;               // Of the padded rectangle on its page
+        int y;
+        int page;
+    } Image;
+
+    typedef struct {
+        int x;
+        int y;               // Lowest free row above [x, x + width)
+        int width;
+    } SkylineNode;
+
+    static int alignUp(int value) {
+        const int alignment = 1 << MAX_MIPMAP_LEVEL;
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    int fit(const std::vector<SkylineNode>& skyline, int index, int width, int height) const;
+    bool place(std::vector<SkylineNode>& skyline, int width, int height, int& x, int& y) const;
+    void blit(const Image& image, SDL_Surface* page) const;
+
+    std::vector<Image> images;
+    std::vector<Entry> entries;
+    std::vector<std::shared_ptr<Texture>> pages;
+};
+
+}  // namespace Opengl
+
+}  // namespace PolandBall
+
+#endif  // TEXTUREATLAS_H
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "InputLog.h"
+#include "Logger.h"
+
+#include <cstring>
+
+namespace PolandBall {
+
+namespace Utils {
+
+bool InputLog::openForWriting(const std::string& path, const Settings& settings) {
+    this->close();
+    this->file.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!this->file.is_open()) {
+        Logger::getInstance().log(Logger::LOG_ERROR, "Failed to open `%s' for writing", path.c_str());
+        return false;
+    }
+
+    this->writeWord(MAGIC, 4);
+    this->writeWord(VERSION, 1);
+    this->writeWord(settings.seed, 4);
+    this->writeWord(settings.solver, 1);
+    this->writeWord(settings.broadPhase, 1);
+    this->writeWord(settings.threads, 2);
+    this->writeWord(settings.stressBlocks, 4);
+    this->writeWord(settings.stressWeapons, 4);
+    this->writeWord(settings.stressPacks, 4);
+    this->writeWord(settings.stressPlayers, 4);
+    this->writeWord(settings.stressSteps, 4);
+    this->writeWord(settings.stressTicks, 4);
+    return true;
+}
+
+bool InputLog::openForReading(const std::string& path, Settings& settings) {
+    this->close();
+    this->file.open(path.c_str(), std::ios::in | std::ios::binary);
+    if (!this->file.is_open()) {
+        Logger::getInstance().log(Logger::LOG_ERROR, "Failed to open `%s' for reading", path.c_str());
+        return false;
+    }
+
+    unsigned int magic = 0;
+    unsigned int version = 0;
+    if (!this->readWord(magic, 4) || magic != MAGIC || !this->readWord(version, 1) || version != VERSION) {
+        Logger::getInstance().log(Logger::LOG_ERROR, "`%s' is not an input record", path.c_str());
+        this->close();
+        return false;
+    }
+
+    unsigned int solver = 0;
+    unsigned int broadPhase = 0;
+    unsigned int threads = 0;
+    unsigned int stress[6] = { 0, 0, 0, 0, 0, 0 };
+    bool complete = this->readWord(settings.seed, 4) && this->readWord(solver, 1) &&
+            this->readWord(broadPhase, 1) && this->readWord(threads, 2);
+    for (int i = 0; i < 6 && complete; i++) {
+        complete = this->readWord(stress[i], 4);
+    }
+
+    if (!complete) {
+        Logger::getInstance().log(Logger::LOG_ERROR, "`%s' is truncated", path.c_str());
+        this->close();
+        return false;
+    }
+
+    settings.solver = solver;
+    settings.broadPhase = broadPhase;
+    settings.threads = threads;
+    settings.stressBlocks = stress[0];
+    settings.stressWeapons = stress[1];
+    settings.stressPacks = stress[2];
+    settings.stressPlayers = stress[3];
+    settings.stressSteps = stress[4];
+    settings.stressTicks = stress[5];
+    return true;
+}
+
+void InputLog::close() {
+    if (this->file.is_open()) {
+        this->file.close();
+    }
+
+    this->file.clear();
+}
+
+void InputLog::write(const InputFrame& frame) {
+    this->writeFloat(frame.frameTime);
+    this->writeWord(frame.buttons, 2);
+
+    // Cursor only when it moved, most ticks are 6 bytes
+    if (frame.buttons & BUTTON_AIM) {
+        this->writeFloat(frame.cursorX);
+        this->writeFloat(frame.cursorY);
+    }
+}
+
+bool InputLog::read(InputFrame& frame) {
+    if (!this->readFloat(frame.frameTime) || !this->readWord(frame.buttons, 2)) {
+        return false;
+    }
+
+    frame.cursorX = 0.0f;
+    frame.cursorY = 0.0f;
+    if (frame.buttons & BUTTON_AIM) {
+        return this->readFloat(frame.cursorX) && this->readFloat(frame.cursorY);
+    }
+
+    return true;
+}
+
+void InputLog::writeWord(unsigned int word, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        this->file.put(static_cast<char>((word >> (i * 8)) & 0xFF));
+    }
+}
+
+bool InputLog::readWord(unsigned int& word, int bytes) {
+    word = 0;
+    for (int i = 0; i < bytes; i++) {
+        int byte = this->file.get();
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+
+        word |= static_cast<unsigned int>(byte) << (i * 8);
+    }
+
+    return true;
+}
+
+void InputLog::writeFloat(float value) {
+    unsigned int word = 0;
+    memcpy(&word, &value, sizeof(word));
+    this->writeWord(word, 4);
+}
+
+bool InputLog::readFloat(float& value) {
+    unsigned int word = 0;
+    if (!this->readWord(word, 4)) {
+        return false;
+    }
+
+    memcpy(&value, &word, sizeof(value));
+    return true;
+}
+
+}  // namespace Utils
+
+}  // namespace PolandBall
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include "NonCopyable.h"
+
+#include <fstream>
+#include <string>
+
+namespace PolandBall {
+
+namespace Utils {
+
+// Input consumed by one simulation tick
+typedef struct {
+    float frameTime;       // Time simulated by the tick
+    unsigned int buttons;  // InputLog::InputButton bits
+    float cursorX;         // World coordinates, meaningful with BUTTON_AIM only
+    float cursorY;
+} InputFrame;
+
+// Compact binary record of ticks, little endian whatever the host is
+class InputLog: public Common::NonCopyable {
+public:
+    enum InputButton {
+        BUTTON_QUIT = 1 << 0,
+        BUTTON_RIGHT = 1 << 1,
+        BUTTON_LEFT = 1 << 2,
+        BUTTON_JUMP = 1 << 3,
+        BUTTON_DROP = 1 << 4,
+        BUTTON_PRIMARY = 1 << 5,
+        BUTTON_SECONDARY = 1 << 6,
+        BUTTON_MEELE = 1 << 7,
+        BUTTON_SHOOT = 1 << 8,  // Held
+        BUTTON_CLICK = 1 << 9,  // Pressed since the previous tick
+        BUTTON_AIM = 1 << 10    // Cursor moved since the previous tick
+    };
+
+    // Everything but the input that decides how a scene evolves
+    typedef struct {
+        unsigned int seed;
+        int solver;
+        int broadPhase;
+        int threads;
+        int stressBlocks;   // StressTest::Counts added per step
+        int stressWeapons;
+        int stressPacks;
+        int stressPlayers;
+        int stressSteps;    // 0 without --stress
+        int stressTicks;    // Ticks per stress step
+    } Settings;
+
+    bool openForWriting(const std::string& path, const Settings& settings);
+    bool openForReading(const std::string& path, Settings& settings);
+    void close();
+
+    bool isOpen() const {
+        return this->file.is_open();
+    }
+
+    void write(const InputFrame& frame);
+    bool read(InputFrame& frame);  // false past the last tick
+
+private:
+    enum {
+        MAGIC = 0x50524250,  // "PBRP"
+        VERSION = 2
+    };
+
+    void writeWord(unsigned int word, int bytes);
+    bool readWord(unsigned int& word, int bytes);
+    void writeFloat(float value);
+    bool readFloat(float& value);
+
+    std::fstream file;
+};
+
+}  // namespace Utils
+
+}  // namespace PolandBall
+
+#endif  // INPUTLOG_H
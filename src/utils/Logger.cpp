@@ -37,6 +37,10 @@ void Logger::log(int level, const char* message, ...) {
 
     FILE* stream = (level == Logger::LOG_ERROR) ? stderr : stdout;
     switch (level) {
+        case Logger::LOG_DEBUG:
+            fprintf(stream, "Debug: ");
+            break;
+
         case Logger::LOG_INFO:
             fprintf(stream, "Info: ");
             break;
@@ -34,7 +34,8 @@ public:
     enum {
         LOG_ERROR,
         LOG_WARNING,
-        LOG_INFO
+        LOG_INFO,
+        LOG_DEBUG  // Per-frame chatter, below the default threshold
     };
 
     static Logger& getInstance() {
@@ -46,6 +47,7 @@ public:
 
     void setThreshold(int threshold) {
         switch (threshold) {
+            case Logger::LOG_DEBUG:
             case Logger::LOG_INFO:
             case Logger::LOG_WARNING:
             case Logger::LOG_ERROR:
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef POOLALLOCATOR_H
+#define POOLALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace PolandBall {
+
+namespace Utils {
+
+// Free list of fixed size blocks, grown by chunks and never given back to the system
+template <std::size_t Size>
+class BlockPool {
+public:
+    static void* allocate() {
+        BlockPool& pool = getInstance();
+        if (pool.head == nullptr) {
+            pool.grow();
+        }
+
+        Block* block = pool.head;
+        pool.head = block->next;
+        return block;
+    }
+
+    static void deallocate(void* pointer) {
+        BlockPool& pool = getInstance();
+        Block* block = static_cast<Block*>(pointer);
+        block->next = pool.head;
+        pool.head = block;
+    }
+
+private:
+    enum {
+        CHUNK_BLOCKS = 64
+    };
+
+    union Block {
+        Block* next;
+        typename std::aligned_storage<Size, alignof(std::max_align_t)>::type storage;
+    };
+
+    BlockPool() {
+        this->head = nullptr;
+    }
+
+    static BlockPool& getInstance() {
+        static BlockPool instance;
+        return instance;
+    }
+
+    void grow() {
+        this->chunks.emplace_back(new Block[CHUNK_BLOCKS]);
+        Block* chunk = this->chunks.back().get();
+
+        for (int i = 0; i < CHUNK_BLOCKS; i++) {
+            chunk[i].next = this->head;
+            this->head = &chunk[i];
+        }
+    }
+
+    std::vector<std::unique_ptr<Block[]>> chunks;
+    Block* head;
+};
+
+// std::allocate_shared() helper: the object and its control block share one pooled block,
+// not thread safe, entities are only created and released by the main thread
+template <typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator() {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(std::size_t count) {
+        if (count != 1) {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        return static_cast<T*>(BlockPool<sizeof(T)>::allocate());
+    }
+
+    void deallocate(T* pointer, std::size_t count) {
+        if (count != 1) {
+            ::operator delete(pointer);
+            return;
+        }
+
+        BlockPool<sizeof(T)>::deallocate(pointer);
+    }
+};
+
+template <typename T, typename U>
+bool operator ==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator !=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return false;
+}
+
+}  // namespace Utils
+
+}  // namespace PolandBall
+
+#endif  // POOLALLOCATOR_H
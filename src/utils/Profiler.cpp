@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Profiler.h"
+#include "Logger.h"
+
+#include <cstdio>
+
+namespace PolandBall {
+
+namespace Utils {
+
+bool Profiler::dump(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        Logger::getInstance().log(Logger::LOG_ERROR, "Failed to open `%s' for writing", path.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    int zones = 0;
+    for (auto& buffer: this->buffers) {
+        // Threads are numbered as they record their first zone, the main loop comes first
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                "\"args\": {\"name\": \"thread %d\"}}", (buffer->thread > 0) ? ",\n" : "",
+                buffer->thread, buffer->thread);
+
+        unsigned long long first = (buffer->next > BUFFER_ZONES) ? buffer->next - BUFFER_ZONES : 0;
+        for (unsigned long long i = first; i < buffer->next; i++) {
+            const Zone& zone = buffer->zones[i & (BUFFER_ZONES - 1)];
+            fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                    "\"ts\": %.3f, \"dur\": %.3f}", zone.name, buffer->thread,
+                    zone.begin / 1000.0, (zone.end - zone.begin) / 1000.0);
+            zones++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    Logger::getInstance().log(Logger::LOG_INFO, "Dumped %d profiler zones to `%s'", zones, path.c_str());
+    return true;
+}
+
+Profiler::ThreadBuffer* Profiler::registerThread() {
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->zones.reset(new Zone[BUFFER_ZONES]);
+    buffer->next = 0;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    buffer->thread = this->buffers.size();
+    getThreadBuffer() = buffer.get();
+    this->buffers.push_back(std::move(buffer));
+
+    return getThreadBuffer();
+}
+
+}  // namespace Utils
+
+}  // namespace PolandBall
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "NonCopyable.h"
+#include "Config.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// PROFILE_ZONE("name") times the enclosing scope, names must be string literals.
+// Without POLANDBALL_PROFILER zones expand to nothing.
+#ifdef POLANDBALL_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) ::PolandBall::Utils::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+namespace PolandBall {
+
+namespace Utils {
+
+class Profiler: public Common::NonCopyable {
+public:
+    typedef struct {
+        const char* name;
+        long long begin;  // Nanoseconds since the profiler was created
+        long long end;
+    } Zone;
+
+    static Profiler& getInstance() {
+        static Profiler instance;
+        return instance;
+    }
+
+    long long now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - this->start).count();
+    }
+
+    void record(const char* name, long long begin, long long end) {
+        ThreadBuffer* buffer = getThreadBuffer();
+        if (buffer == nullptr) {
+            buffer = this->registerThread();
+        }
+
+        buffer->zones[buffer->next & (BUFFER_ZONES - 1)] = {name, begin, end};
+        buffer->next++;
+    }
+
+    // Chrome trace-event JSON of the zones still held by the ring buffers.
+    // Call it between frames, while worker threads are idle.
+    bool dump(const std::string& path);
+
+private:
+    enum {
+        BUFFER_ZONES = 1 << 16  // Per thread, power of two
+    };
+
+    typedef struct {
+        std::unique_ptr<Zone[]> zones;
+        unsigned long long next;  // Zones ever recorded, the ring wraps over
+        int thread;
+    } ThreadBuffer;
+
+    Profiler():
+            start(std::chrono::steady_clock::now()) {
+    }
+
+    static ThreadBuffer*& getThreadBuffer() {
+        static thread_local ThreadBuffer* buffer = nullptr;
+        return buffer;
+    }
+
+    ThreadBuffer* registerThread();
+
+    std::chrono::steady_clock::time_point start;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::mutex mutex;
+};
+
+class ProfileZone: public Common::NonCopyable {
+public:
+    ProfileZone(const char* name):
+            name(name),
+            begin(Profiler::getInstance().now()) {
+    }
+
+    ~ProfileZone() {
+        Profiler& profiler = Profiler::getInstance();
+        profiler.record(this->name, this->begin, profiler.now());
+    }
+
+private:
+    const char* name;
+    long long begin;
+};
+
+}  // namespace Utils
+
+}  // namespace PolandBall
+
+#endif  // PROFILER_H
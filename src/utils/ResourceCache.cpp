@@ -23,21 +23,32 @@
 #include "ResourceCache.h"
 #include "Logger.h"
 #include "ShaderLoader.h"
+#include "Context.h"
+#include "Profiler.h"
+#include "TextureAtlas.h"
 
 #include <fstream>
+#include <unordered_set>
 
 namespace PolandBall {
 
 namespace Utils {
 
-std::shared_ptr<Opengl::Texture>& ResourceCache::loadTexture(const std::string& name) {
+const std::shared_ptr<Opengl::Texture>& ResourceCache::loadTexture(const std::string& name) {
+    PROFILE_ZONE("ResourceCache::loadTexture");
+    static const std::shared_ptr<Opengl::Texture> none;  // Handed out on failure, never cached
+
+    if (!Opengl::Context::isAvailable()) {
+        return none;  // Nothing to upload to
+    }
+
     if (this->textureCache.find(name) == this->textureCache.end()) {
         Logger::getInstance().log(Logger::LOG_INFO, "Image `%s' not in cache, trying to load", name.c_str());
 
         SDL_Surface* image = IMG_Load(this->buildPath(name).c_str());
         if (image == nullptr) {
             Logger::getInstance().log(Logger::LOG_ERROR, "IMG_Load() failed: %s", IMG_GetError());
-            return this->textureCache["nullptr"];
+            return none;
         }
 
         std::shared_ptr<Opengl::Texture> texture(new Opengl::Texture());
@@ -52,7 +63,14 @@ std::shared_ptr<Opengl::Texture>& ResourceCache::loadTexture(const std::string&
     return this->textureCache.at(name);
 }
 
-std::shared_ptr<Opengl::RenderEffect>& ResourceCache::loadEffect(const std::string& name) {
+const std::shared_ptr<Opengl::RenderEffect>& ResourceCache::loadEffect(const std::string& name) {
+    PROFILE_ZONE("ResourceCache::loadEffect");
+    static const std::shared_ptr<Opengl::RenderEffect> none;
+
+    if (!Opengl::Context::isAvailable()) {
+        return none;
+    }
+
     if (this->effectCache.find(name) == this->effectCache.end()) {
         Logger::getInstance().log(Logger::LOG_INFO, "Shader `%s' not in cache, trying to load", name.c_str());
 
@@ -60,7 +78,7 @@ std::shared_ptr<Opengl::RenderEffect>& ResourceCache::loadEffect(const std::stri
         auto shaderSource = this->loadSource(fullPath.c_str());
         if (shaderSource == nullptr) {
             Logger::getInstance().log(Logger::LOG_ERROR, "Failed to open `%s'", fullPath.c_str());
-            return this->effectCache["nullptr"];
+            return none;
         }
 
         this->insertEffect(name, shaderSource.get());
@@ -71,7 +89,10 @@ std::shared_ptr<Opengl::RenderEffect>& ResourceCache::loadEffect(const std::stri
     return this->effectCache.at(name);
 }
 
-std::shared_ptr<json_object>& ResourceCache::loadAsset(const std::string& name) {
+const std::shared_ptr<json_object>& ResourceCache::loadAsset(const std::string& name) {
+    PROFILE_ZONE("ResourceCache::loadAsset");
+    static const std::shared_ptr<json_object> none;
+
     std::shared_ptr<json_object> object;
 
     if (this->assetCache.find(name) == this->assetCache.end()) {
@@ -81,7 +102,7 @@ std::shared_ptr<json_object>& ResourceCache::loadAsset(const std::string& name)
         auto entitySource = this->loadSource(fullPath.c_str());
         if (entitySource == nullptr) {
             Logger::getInstance().log(Logger::LOG_ERROR, "Failed to open `%s'", fullPath.c_str());
-            return this->assetCache["nullptr"];
+            return none;
         }
 
         json_tokener_error parseError;
@@ -90,7 +111,7 @@ std::shared_ptr<json_object>& ResourceCache::loadAsset(const std::string& name)
         if (object == nullptr) {
             Logger::getInstance().log(Logger::LOG_ERROR, "Failed to parse `%s': %s",
                     fullPath.c_str(), json_tokener_error_desc(parseError));
-            return this->assetCache["nullptr"];
+            return none;
         }
 
         this->assetCache.insert(std::make_pair(name, object));
@@ -101,7 +122,14 @@ std::shared_ptr<json_object>& ResourceCache::loadAsset(const std::string& name)
     return this->assetCache.at(name);
 }
 
-std::shared_ptr<TTF_Font>& ResourceCache::loadFont(const std::string& name, unsigned int size) {
+const std::shared_ptr<TTF_Font>& ResourceCache::loadFont(const std::string& name, unsigned int size) {
+    PROFILE_ZONE("ResourceCache::loadFont");
+    static const std::shared_ptr<TTF_Font> none;
+
+    if (!Opengl::Context::isAvailable()) {
+        return none;  // SDL_ttf is not initialized either
+    }
+
     if (this->fontCache[name].find(size) == this->fontCache[name].end()) {
         Logger::getInstance().log(Logger::LOG_INFO,
                 "Font `%s' (%dpt) not in cache, trying to load", name.c_str(), size);
@@ -109,7 +137,7 @@ std::shared_ptr<TTF_Font>& ResourceCache::loadFont(const std::string& name, unsi
         std::shared_ptr<TTF_Font> font(TTF_OpenFont(this->buildPath(name).c_str(), size), TTF_CloseFont);
         if (font == nullptr) {
             Logger::getInstance().log(Logger::LOG_ERROR, "TTF_OpenFont() failed: %s", TTF_GetError());
-            return this->fontCache[name][-1];
+            return none;
         }
 
         this->fontCache[name].insert(std::make_pair(size, font));
@@ -121,7 +149,82 @@ std::shared_ptr<TTF_Font>& ResourceCache::loadFont(const std::string& name, unsi
     return this->fontCache[name][size];
 }
 
+bool ResourceCache::buildAtlas(const std::vector<std::string>& assetNames) {
+    PROFILE_ZONE("ResourceCache::buildAtlas");
+
+    if (!Opengl::Context::isAvailable()) {
+        return false;
+    }
+
+    Opengl::TextureAtlas atlas;
+    std::unordered_set<std::string> textureNames;
+
+    for (auto& assetName: assetNames) {
+        auto asset = this->loadAsset(assetName);
+        json_object* texture = nullptr;
+        if (asset == nullptr || !json_object_object_get_ex(asset.get(), "texture", &texture) ||
+                json_object_get_type(texture) != json_type_string) {
+            continue;
+        }
+
+        std::string textureName(json_object_get_string(texture));
+        if (this->textureCache.find(textureName) != this->textureCache.end() ||
+                !textureNames.insert(textureName).second) {
+            continue;  // Already loaded on its own or packed
+        }
+
+        SDL_Surface* image = IMG_Load(this->buildPath(textureName).c_str());
+        if (image == nullptr) {
+            Logger::getInstance().log(Logger::LOG_ERROR, "IMG_Load() failed: %s", IMG_GetError());
+            continue;
+        }
+
+        if (!atlas.add(textureName, image)) {
+            Logger::getInstance().log(Logger::LOG_WARNING, "Image `%s' does not fit an atlas page",
+                    textureName.c_str());
+        }
+
+        SDL_FreeSurface(image);
+    }
+
+    if (!atlas.build()) {
+        Logger::getInstance().log(Logger::LOG_ERROR, "SDL_CreateRGBSurface() failed: %s", SDL_GetError());
+        return false;
+    }
+
+    auto& pages = atlas.getPages();
+    for (auto& entry: atlas.getEntries()) {
+        this->textureCache[entry.name] = pages[entry.page];
+        this->regionCache[entry.name] = entry.region;
+    }
+
+    this->atlasPages.insert(this->atlasPages.end(), pages.begin(), pages.end());
+    Logger::getInstance().log(Logger::LOG_INFO, "Packed %d images into %d atlas pages",
+            static_cast<int>(atlas.getEntries().size()), static_cast<int>(pages.size()));
+
+    return true;
+}
+
+const Math::Vec4& ResourceCache::getRegion(const std::string& textureName) const {
+    static const Math::Vec4 whole(0.0f, 0.0f, 1.0f, 1.0f);
+
+    auto region = this->regionCache.find(textureName);
+    return (region != this->regionCache.end()) ? region->second : whole;
+}
+
 void ResourceCache::purge() {
+    // Atlased names alias their page, only the page itself counts
+    for (auto& region: this->regionCache) {
+        this->textureCache.erase(region.first);
+    }
+
+    for (auto& page: this->atlasPages) {
+        if (!page.unique()) {
+            Logger::getInstance().log(Logger::LOG_WARNING, "Texture %p has %d references left!",
+                    page.get(), page.use_count() - 1);
+        }
+    }
+
     for (auto& texture: this->textureCache) {
         if (!texture.second.unique() && texture.second != nullptr) {
             Logger::getInstance().log(Logger::LOG_WARNING, "Texture %p has %d references left!",
@@ -155,6 +258,8 @@ void ResourceCache::purge() {
     }
 
     this->textureCache.clear();
+    this->regionCache.clear();
+    this->atlasPages.clear();
     this->effectCache.clear();
     this->assetCache.clear();
     this->fontCache.clear();
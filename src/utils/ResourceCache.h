@@ -31,7 +31,9 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 #include <json-c/json.h>
+#include <Vec4.h>
 #include <unordered_map>
+#include <vector>
 #include <string>
 #include <memory>
 #include <sstream>
@@ -42,10 +44,16 @@ namespace Utils {
 
 class ResourceCache: public Common::NonCopyable {
 public:
-    std::shared_ptr<Opengl::Texture>& loadTexture(const std::string& name);
-    std::shared_ptr<Opengl::RenderEffect>& loadEffect(const std::string& name);
-    std::shared_ptr<json_object>& loadAsset(const std::string& name);
-    std::shared_ptr<TTF_Font>& loadFont(const std::string& name, unsigned int size);
+    const std::shared_ptr<Opengl::Texture>& loadTexture(const std::string& name);
+    const std::shared_ptr<Opengl::RenderEffect>& loadEffect(const std::string& name);
+    const std::shared_ptr<json_object>& loadAsset(const std::string& name);
+    const std::shared_ptr<TTF_Font>& loadFont(const std::string& name, unsigned int size);
+
+    // Packs the textures of the assets into shared atlas pages, loadTexture() then returns their page
+    bool buildAtlas(const std::vector<std::string>& assetNames);
+
+    // Where loadTexture() put the texture on its page, the whole texture if it is not in an atlas
+    const Math::Vec4& getRegion(const std::string& textureName) const;
 
     void purge();
 
@@ -67,6 +75,8 @@ private:
     std::unique_ptr<char[]> loadSource(const std::string& name) const;
 
     std::unordered_map<std::string, std::shared_ptr<Opengl::Texture>> textureCache;
+    std::unordered_map<std::string, Math::Vec4> regionCache;  // Textures loaded from atlas pages
+    std::vector<std::shared_ptr<Opengl::Texture>> atlasPages;
     std::unordered_map<std::string, std::shared_ptr<Opengl::RenderEffect>> effectCache;
     std::unordered_map<std::string, std::shared_ptr<json_object>> assetCache;
     std::unordered_map<std::string, std::unordered_map<int, std::shared_ptr<TTF_Font>>> fontCache;
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ThreadPool.h"
+
+namespace PolandBall {
+
+namespace Utils {
+
+ThreadPool::ThreadPool(int threads):
+        nextTask(0) {
+    this->tasks = 0;
+    this->busyWorkers = 0;
+    this->generation = 0;
+    this->stopping = false;
+
+    for (int thread = 1; thread < threads; thread++) {
+        this->workers.push_back(std::thread(&ThreadPool::work, this, thread));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+
+    this->wakeUp.notify_all();
+    for (auto& worker: this->workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(int tasks, const std::function<void(int, int)>& task) {
+    if (this->workers.empty() || tasks < 2) {
+        for (int index = 0; index < tasks; index++) {
+            task(index, 0);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->task = task;
+        this->tasks = tasks;
+        this->nextTask = 0;
+        this->busyWorkers = this->workers.size();
+        this->generation++;
+    }
+
+    this->wakeUp.notify_all();
+    this->drain(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->finished.wait(lock, [this]() -> bool {
+        return this->busyWorkers == 0;
+    });
+
+    this->task = nullptr;
+}
+
+void ThreadPool::work(int thread) {
+    unsigned int generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wakeUp.wait(lock, [this, generation]() -> bool {
+                return this->stopping || this->generation != generation;
+            });
+
+            if (this->stopping) {
+                return;
+            }
+
+            generation = this->generation;
+        }
+
+        this->drain(thread);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (--this->busyWorkers == 0) {
+            this->finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::drain(int thread) {
+    for (int index = this->nextTask++; index < this->tasks; index = this->nextTask++) {
+        this->task(index, thread);
+    }
+}
+
+}  // namespace Utils
+
+}  // namespace PolandBall
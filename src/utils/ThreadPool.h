@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2013 Pavlo Lavrenenko
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "NonCopyable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PolandBall {
+
+namespace Utils {
+
+// Fixed set of workers sharing batches of indexed tasks with the calling thread
+class ThreadPool: public Common::NonCopyable {
+public:
+    ThreadPool(int threads);
+    ~ThreadPool();
+
+    // Workers plus the calling thread
+    int getThreads() const {
+        return this->workers.size() + 1;
+    }
+
+    // Calls task(index, thread) for every index below tasks, returns once all are done.
+    // Thread 0 is the caller, indexes are handed out in order but finish in any order.
+    void run(int tasks, const std::function<void(int, int)>& task);
+
+private:
+    void work(int thread);
+    void drain(int thread);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+
+    std::function<void(int, int)> task;
+    std::atomic<int> nextTask;
+    int tasks;
+    int busyWorkers;
+    unsigned int generation;
+    bool stopping;
+};
+
+}  // namespace Utils
+
+}  // namespace PolandBall
+
+#endif  // THREADPOOL_H